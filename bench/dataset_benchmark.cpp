@@ -0,0 +1,274 @@
+#include "../src/header/basic_image_operations.hpp"
+#include "../src/header/colors.hpp"
+#include "../src/header/pipeline_config.hpp"
+#include "../src/header/pipeline_graph.hpp"
+#include "../src/header/preprocessing_pipeline.hpp"
+#include "../src/header/thread_pool.hpp"
+#include <opencv2/opencv.hpp>
+#include <sys/resource.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// End-to-end benchmark over every labeled folder of traffic_sign_images/. Each image is decoded and run through
+// the pipeline graph of --config (the built-in default without it), exactly as ImageProcessingCpp --config
+// runs it, and the report combines throughput, per-stage latency percentiles and peak memory with per-class
+// detection counts, so a performance or configuration change can be checked against accuracy in a single run.
+//
+// Every image in a sign folder is expected to contain exactly one sign: an image counts as detected when at
+// least one fused box is found, and further boxes are counted as false positives. Every box in the "false"
+// folder is a false positive.
+//
+// When a resize stage reads the source image, images are decoded at its factor by default, like the batch
+// pipeline does, and the stage runs with factor 1: "decode" then covers the downscaling and the resize stage
+// stays near zero. --full-decode decodes at full resolution and leaves the resize stage as configured.
+//
+// Usage: dataset_benchmark [--config PATH] [--dataset DIR] [--max-images N] [--passes N] [--threads N] [--full-decode]
+//                          [--output PATH]
+
+namespace {
+    struct LabeledImage {
+        std::string label;
+        std::string path;
+    };
+
+    struct ImageMeasurement {
+        std::vector<double> stage_ms;
+        size_t boxes = 0;
+        bool loaded = false;
+    };
+
+    struct ClassReport {
+        int images = 0;
+        int images_with_boxes = 0;
+        size_t boxes = 0;
+        size_t false_positive_boxes = 0;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point& start) {
+        Clock::time_point now = Clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - start).count();
+        start = now;
+        return ms;
+    }
+
+    // Moves the downscaling of a resize stage on the source image into the decoder: returns the stage's factor
+    // and sets it to 1, or returns 1 if no stage resizes the source.
+    int take_source_resize_factor(pipeline_config::PipelineConfig& config) {
+        for (auto& stage : config.stages) {
+            if (stage.type == "resize" && stage.inputs == std::vector<std::string>{"source"}) {
+                int factor = stage.get_int("factor", pipeline_preprocessing::RESIZE_FACTOR);
+                if (factor <= 1) return 1;      // nothing to move; an invalid factor is reported by the graph
+                stage.params["factor"] = "1";
+                return factor;
+            }
+        }
+        return 1;
+    }
+
+    // stage_ms holds decode, the graph stages in graph.stage_names() order, and total.
+    ImageMeasurement measure_image(const pipeline_graph::PipelineGraph& graph, const std::string& path, int image_index,
+                                   int decode_factor) {
+        ImageMeasurement measurement;
+        Clock::time_point image_start = Clock::now();
+        Clock::time_point start = image_start;
+
+        cv::Mat image = decode_factor > 1 ? basic_ops::load_image_scaled(path, decode_factor, false)
+                                          : basic_ops::load_image(path, false);
+        double decode_ms = elapsed_ms(start);
+        if (image.empty()) return measurement;
+        measurement.loaded = true;
+
+        measurement.boxes = graph.run(image, image_index, false, &measurement.stage_ms).bounding_boxes.size();
+        measurement.stage_ms.insert(measurement.stage_ms.begin(), decode_ms);
+        measurement.stage_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - image_start).count());
+        return measurement;
+    }
+
+    double percentile(std::vector<double> samples, double p) {
+        if (samples.empty()) return 0.0;
+        std::sort(samples.begin(), samples.end());
+        size_t rank = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+        return samples[std::min(rank, samples.size() - 1)];
+    }
+
+    long peak_memory_kb() {
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;  // kilobytes on Linux
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string config_path;
+    std::string dataset_dir = "../traffic_sign_images";
+    int max_images = 100;
+    int passes = 1;
+    size_t num_threads = 0;
+    std::string output_path;
+    bool full_decode = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (arg == "--dataset" && i + 1 < argc) {
+            dataset_dir = argv[++i];
+        } else if (arg == "--max-images" && i + 1 < argc) {
+            max_images = std::stoi(argv[++i]);
+        } else if (arg == "--passes" && i + 1 < argc) {
+            passes = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = static_cast<size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--full-decode") {
+            full_decode = true;
+        } else if (arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<LabeledImage> images;
+    for (const auto& label : pipeline_preprocessing::get_dataset_labels()) {
+        for (const auto& path : basic_ops::list_image_paths(dataset_dir + "/" + label, max_images)) {
+            images.push_back({label, path});
+        }
+    }
+    if (images.empty()) {
+        std::cerr << "Error: No images found under " << dataset_dir << std::endl;
+        return 2;
+    }
+
+    pipeline_config::PipelineConfig config;
+    try {
+        config = config_path.empty() ? pipeline_config::default_config() : pipeline_config::load_config(config_path);
+    } catch (const std::runtime_error& error) {
+        std::cerr << "Error: " << error.what() << std::endl;
+        return 2;
+    }
+    int decode_factor = full_decode ? 1 : take_source_resize_factor(config);
+
+    // The color LUT is built once per process; keep it out of the per-image latencies.
+    Clock::time_point lut_start = Clock::now();
+    colors::get_color_lut();
+    double lut_ms = elapsed_ms(lut_start);
+
+    // Like Detector: images run in parallel on the pool, and independent branches of one image on it as well.
+    ThreadPool pool(num_threads);
+    std::unique_ptr<pipeline_graph::PipelineGraph> graph;
+    try {
+        graph = std::make_unique<pipeline_graph::PipelineGraph>(config, &pool);
+    } catch (const std::runtime_error& error) {
+        std::cerr << "Error: " << error.what() << std::endl;
+        return 2;
+    }
+    std::vector<std::string> stage_names = {"decode"};
+    for (const auto& name : graph->stage_names()) stage_names.push_back("stage:" + name);
+    stage_names.push_back("total");
+
+    std::vector<ImageMeasurement> measurements(images.size() * passes);
+    Clock::time_point run_start = Clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        pool.parallel_for(images.size(), [&](size_t i) {
+            measurements[pass * images.size() + i] = measure_image(*graph, images[i].path, static_cast<int>(i), decode_factor);
+        });
+    }
+    double run_s = std::chrono::duration<double>(Clock::now() - run_start).count();
+
+    std::map<std::string, ClassReport> class_reports;
+    std::vector<std::vector<double>> stage_samples(stage_names.size());
+    size_t processed = 0;
+    for (size_t m = 0; m < measurements.size(); m++) {
+        const ImageMeasurement& measurement = measurements[m];
+        if (!measurement.loaded) continue;
+        processed++;
+        for (size_t s = 0; s < stage_names.size(); s++) stage_samples[s].push_back(measurement.stage_ms[s]);
+
+        // Detection quality is the same on every pass, so it is only counted on the first one.
+        if (m >= images.size()) continue;
+        const std::string& label = images[m].label;
+        ClassReport& report = class_reports[label];
+        report.images++;
+        report.boxes += measurement.boxes;
+        if (measurement.boxes > 0) report.images_with_boxes++;
+        if (label == "false") {
+            report.false_positive_boxes += measurement.boxes;
+        } else if (measurement.boxes > 1) {
+            report.false_positive_boxes += measurement.boxes - 1;
+        }
+    }
+
+    double images_per_second = processed / run_s;
+    long peak_kb = peak_memory_kb();
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "config: " << (config_path.empty() ? "built-in default" : config_path) << "\n";
+    std::cout << "images: " << processed << " (" << images.size() << " x " << passes << " passes), threads: "
+              << pool.size() << ", decode: " << (decode_factor > 1 ? "1/" + std::to_string(decode_factor) : "full") << "\n";
+    std::cout << "throughput: " << images_per_second << " images/s, wall time: " << run_s << " s\n";
+    std::cout << "color LUT build: " << lut_ms << " ms, peak RSS: " << peak_kb / 1024.0 << " MiB\n\n";
+
+    std::cout << std::left << std::setw(28) << "stage" << std::right << std::setw(10) << "p50 ms"
+              << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << "\n";
+    for (size_t s = 0; s < stage_names.size(); s++) {
+        std::cout << std::left << std::setw(28) << stage_names[s] << std::right
+                  << std::setw(10) << percentile(stage_samples[s], 50) << std::setw(10) << percentile(stage_samples[s], 90)
+                  << std::setw(10) << percentile(stage_samples[s], 99) << std::setw(10) << percentile(stage_samples[s], 100)
+                  << "\n";
+    }
+
+    std::cout << "\n" << std::left << std::setw(10) << "class" << std::right << std::setw(8) << "images"
+              << std::setw(10) << "detected" << std::setw(8) << "boxes" << std::setw(8) << "fp" << "\n";
+    for (const auto& label : pipeline_preprocessing::get_dataset_labels()) {
+        const ClassReport& report = class_reports[label];
+        std::cout << std::left << std::setw(10) << label << std::right << std::setw(8) << report.images
+                  << std::setw(10) << (label == "false" ? 0 : report.images_with_boxes)
+                  << std::setw(8) << report.boxes << std::setw(8) << report.false_positive_boxes << "\n";
+    }
+    std::cout << std::flush;
+
+    if (!output_path.empty()) {
+        std::ofstream json(output_path);
+        if (!json) {
+            std::cerr << "Error: Unable to write " << output_path << std::endl;
+            return 2;
+        }
+        json << std::setprecision(6);
+        json << "{\n  \"benchmark\": \"dataset\",\n  \"config\": \"" << (config_path.empty() ? "default" : config_path) << "\",\n"
+             << "  \"dataset\": \"" << dataset_dir << "\",\n"
+             << "  \"images\": " << processed << ",\n  \"passes\": " << passes << ",\n"
+             << "  \"threads\": " << pool.size() << ",\n  \"decode_factor\": " << decode_factor << ",\n"
+             << "  \"images_per_second\": " << images_per_second << ",\n"
+             << "  \"wall_time_s\": " << run_s << ",\n  \"color_lut_ms\": " << lut_ms << ",\n"
+             << "  \"peak_rss_kb\": " << peak_kb << ",\n  \"stages\": {\n";
+        for (size_t s = 0; s < stage_names.size(); s++) {
+            json << "    \"" << stage_names[s] << "\": {\"p50_ms\": " << percentile(stage_samples[s], 50)
+                 << ", \"p90_ms\": " << percentile(stage_samples[s], 90) << ", \"p99_ms\": " << percentile(stage_samples[s], 99)
+                 << ", \"max_ms\": " << percentile(stage_samples[s], 100) << "}"
+                 << (s + 1 < stage_names.size() ? ",\n" : "\n");
+        }
+        json << "  },\n  \"classes\": {\n";
+        const std::vector<std::string>& labels = pipeline_preprocessing::get_dataset_labels();
+        for (size_t l = 0; l < labels.size(); l++) {
+            const ClassReport& report = class_reports[labels[l]];
+            json << "    \"" << labels[l] << "\": {\"images\": " << report.images
+                 << ", \"images_with_boxes\": " << report.images_with_boxes << ", \"boxes\": " << report.boxes
+                 << ", \"false_positive_boxes\": " << report.false_positive_boxes << "}"
+                 << (l + 1 < labels.size() ? ",\n" : "\n");
+        }
+        json << "  }\n}\n";
+        std::cout << "Results written to " << output_path << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,396 @@
+#include "../src/header/filters.hpp"
+#include "../src/header/morphology.hpp"
+#include "../src/header/statistical_operations.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Microbenchmark for the hand-written kernels in filters.cpp, morphology.cpp and stat_ops::gauss_filter. Every
+// kernel is run across image sizes, channel counts and kernel sizes next to its OpenCV equivalent; timings and an
+// output comparison are written as JSON so regressions show up when kernels get optimized.
+//
+// Usage: filters_benchmark [--sizes 320x240,640x480] [--kernels 3,5,9] [--min-time SECONDS]
+//                          [--max-repeats N] [--opencv-threads N] [--image PATH] [--filter NAME]
+//                          [--output PATH] [--fail-on-mismatch]
+
+namespace {
+    struct BenchCase {
+        int width;
+        int height;
+        int channels;
+        int kernel_size;
+        cv::Mat input;
+    };
+
+    using KernelFunction = std::function<cv::Mat(const BenchCase&)>;
+
+    struct KernelSpec {
+        std::string name;
+        std::vector<int> channels;  // channel counts the kernel supports
+        bool uses_kernel_size;
+        int tolerance;              // max abs difference per pixel still counted as a match
+        KernelFunction custom;
+        KernelFunction reference;
+    };
+
+    struct Timing {
+        double median_ms = 0.0;
+        double min_ms = 0.0;
+        double mean_ms = 0.0;
+        int repeats = 0;
+    };
+
+    struct Comparison {
+        double max_abs_diff = 0.0;
+        double mean_abs_diff = 0.0;
+        int mismatched_values = 0;
+        bool match = false;
+    };
+
+    struct BenchResult {
+        std::string kernel;
+        BenchCase bench_case;
+        int tolerance;
+        Timing custom;
+        Timing reference;
+        Comparison comparison;
+    };
+
+    cv::Mat sobel_magnitude(const cv::Mat& image) {
+        cv::Mat gx, gy, magnitude, output;
+        cv::Sobel(image, gx, CV_32F, 1, 0, 3, 1, 0, cv::BORDER_CONSTANT);
+        cv::Sobel(image, gy, CV_32F, 0, 1, 3, 1, 0, cv::BORDER_CONSTANT);
+        cv::magnitude(gx, gy, magnitude);
+        magnitude.convertTo(output, CV_8U);
+        return output;
+    }
+
+    cv::Mat median_reflect(const cv::Mat& image, int dim) {
+        // medianBlur always replicates the border, medianFilterSorted reflects it.
+        int pad = dim / 2;
+        cv::Mat padded, output;
+        cv::copyMakeBorder(image, padded, pad, pad, pad, pad, cv::BORDER_REFLECT);
+        cv::medianBlur(padded, output, dim);
+        return output(cv::Rect(pad, pad, image.cols, image.rows)).clone();
+    }
+
+    cv::Mat clipped_box_mean(const cv::Mat& image, int dim) {
+        // gauss_filter averages only the pixels of the window that lie inside the image.
+        cv::Mat sums, counts, output;
+        cv::Size window(dim, dim);
+        cv::boxFilter(image, sums, CV_32F, window, cv::Point(-1, -1), false, cv::BORDER_CONSTANT);
+        cv::boxFilter(cv::Mat::ones(image.size(), CV_32F), counts, CV_32F, window, cv::Point(-1, -1), false, cv::BORDER_CONSTANT);
+        cv::divide(sums, counts, output);
+        output.convertTo(output, CV_8U);
+        return output;
+    }
+
+    cv::Mat morphology_reference(const cv::Mat& image, int operation, int dim) {
+        cv::Mat out;
+        cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(dim, dim));
+        cv::morphologyEx(image, out, operation, element, cv::Point(-1, -1), 1, cv::BORDER_REPLICATE);
+        return out;
+    }
+
+    std::vector<KernelSpec> kernel_specs() {
+        return {
+            {"grayScaleFilter", {3}, false, 1,
+             [](const BenchCase& b) { return filters::grayScaleFilter(b.input); },
+             [](const BenchCase& b) { cv::Mat out; cv::cvtColor(b.input, out, cv::COLOR_BGR2GRAY); return out; }},
+            {"blackWhiteFilter", {1}, false, 0,
+             [](const BenchCase& b) { return filters::blackWhiteFilter(b.input, 128); },
+             [](const BenchCase& b) { cv::Mat out; cv::threshold(b.input, out, 127, 255, cv::THRESH_BINARY); return out; }},
+            {"blurFilter", {1, 3}, true, 1,
+             [](const BenchCase& b) { return filters::blurFilter(b.input, b.kernel_size, b.kernel_size * b.kernel_size); },
+             [](const BenchCase& b) {
+                 cv::Mat out;
+                 cv::blur(b.input, out, cv::Size(b.kernel_size, b.kernel_size), cv::Point(-1, -1), cv::BORDER_CONSTANT);
+                 return out;
+             }},
+            {"gauss_filter", {1}, true, 1,
+             [](const BenchCase& b) { return stat_ops::gauss_filter(b.input, b.kernel_size); },
+             [](const BenchCase& b) { return clipped_box_mean(b.input, b.kernel_size); }},
+            {"sobelFilter", {1}, false, 1,
+             [](const BenchCase& b) { return filters::sobelFilter(b.input, "both", 1); },
+             [](const BenchCase& b) { return sobel_magnitude(b.input); }},
+            {"sobelFilterFFT", {1}, false, 1,
+             [](const BenchCase& b) { return filters::sobelFilterFFT(b.input, "both", 1); },
+             [](const BenchCase& b) { return sobel_magnitude(b.input); }},
+            {"laplaceFilter", {1}, false, 0,
+             [](const BenchCase& b) { return filters::laplaceFilter(b.input, 4, 0); },
+             [](const BenchCase& b) {
+                 cv::Mat kernel = (cv::Mat_<float>(3, 3) << 0, -1, 0, -1, 4, -1, 0, -1, 0);
+                 cv::Mat out;
+                 cv::filter2D(b.input, out, CV_8U, kernel, cv::Point(-1, -1), 0, cv::BORDER_REPLICATE);
+                 return out;
+             }},
+            {"linearGrayScaling", {1}, false, 1,
+             [](const BenchCase& b) { return filters::linearGrayScaling(b.input.clone(), 10.0f, 1.5f); },
+             [](const BenchCase& b) { cv::Mat out; b.input.convertTo(out, CV_8U, 1.5, 15.0); return out; }},
+            {"isodensityFilter", {1}, false, 0,
+             [](const BenchCase& b) { return filters::isodensityFilter(b.input, 2); },
+             [](const BenchCase& b) {
+                 cv::Mat out;
+                 double mu = cv::mean(b.input)[0];
+                 cv::threshold(b.input, out, std::ceil(mu) - 1.0, 255, cv::THRESH_BINARY);
+                 return out;
+             }},
+            {"erosion", {1, 3}, true, 0,
+             [](const BenchCase& b) { return filters::erosion(b.input, b.kernel_size); },
+             [](const BenchCase& b) {
+                 cv::Mat out;
+                 cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(b.kernel_size, b.kernel_size));
+                 cv::erode(b.input, out, element, cv::Point(-1, -1), 1, cv::BORDER_REPLICATE);
+                 return out;
+             }},
+            {"dilation", {1, 3}, true, 0,
+             [](const BenchCase& b) { return filters::dilation(b.input, b.kernel_size); },
+             [](const BenchCase& b) {
+                 cv::Mat out;
+                 cv::Mat element = cv::getStructuringElement(cv::MORPH_RECT, cv::Size(b.kernel_size, b.kernel_size));
+                 cv::dilate(b.input, out, element, cv::Point(-1, -1), 1, cv::BORDER_REPLICATE);
+                 return out;
+             }},
+            {"morphology_opening", {1, 3}, true, 0,
+             [](const BenchCase& b) { return morphology::opening(b.input, b.kernel_size); },
+             [](const BenchCase& b) { return morphology_reference(b.input, cv::MORPH_OPEN, b.kernel_size); }},
+            {"morphology_closing", {1, 3}, true, 0,
+             [](const BenchCase& b) { return morphology::closing(b.input, b.kernel_size); },
+             [](const BenchCase& b) { return morphology_reference(b.input, cv::MORPH_CLOSE, b.kernel_size); }},
+            {"morphology_gradient", {1, 3}, true, 0,
+             [](const BenchCase& b) { return morphology::gradient(b.input, b.kernel_size); },
+             [](const BenchCase& b) { return morphology_reference(b.input, cv::MORPH_GRADIENT, b.kernel_size); }},
+            {"morphology_top_hat", {1, 3}, true, 0,
+             [](const BenchCase& b) { return morphology::top_hat(b.input, b.kernel_size); },
+             [](const BenchCase& b) { return morphology_reference(b.input, cv::MORPH_TOPHAT, b.kernel_size); }},
+            {"medianFilter", {1, 3}, true, 0,
+             [](const BenchCase& b) { return filters::medianFilter(b.input, b.kernel_size); },
+             [](const BenchCase& b) { cv::Mat out; cv::medianBlur(b.input, out, b.kernel_size); return out; }},
+            {"medianFilterSorted", {1, 3}, true, 0,
+             [](const BenchCase& b) { return filters::medianFilterSorted(b.input, b.kernel_size); },
+             [](const BenchCase& b) { return median_reflect(b.input, b.kernel_size); }},
+        };
+    }
+
+    template<typename Function>
+    Timing time_function(const Function& function, double min_time_s, int max_repeats, cv::Mat& output) {
+        std::vector<double> samples;
+        double elapsed_s = 0.0;
+        while (samples.empty() || (elapsed_s < min_time_s && static_cast<int>(samples.size()) < max_repeats)) {
+            auto start = std::chrono::steady_clock::now();
+            output = function();
+            auto end = std::chrono::steady_clock::now();
+            double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            samples.push_back(ms);
+            elapsed_s += ms / 1000.0;
+        }
+
+        Timing timing;
+        timing.repeats = static_cast<int>(samples.size());
+        timing.mean_ms = 0.0;
+        for (double sample : samples) timing.mean_ms += sample;
+        timing.mean_ms /= samples.size();
+        std::sort(samples.begin(), samples.end());
+        timing.min_ms = samples.front();
+        timing.median_ms = samples[samples.size() / 2];
+        return timing;
+    }
+
+    Comparison compare_outputs(const cv::Mat& output, const cv::Mat& reference, int tolerance) {
+        Comparison comparison;
+        if (output.size() != reference.size() || output.type() != reference.type()) {
+            comparison.max_abs_diff = -1.0;
+            return comparison;
+        }
+        cv::Mat diff;
+        cv::absdiff(output, reference, diff);
+        diff = diff.reshape(1);
+        cv::minMaxLoc(diff, nullptr, &comparison.max_abs_diff);
+        comparison.mean_abs_diff = cv::mean(diff)[0];
+        comparison.mismatched_values = cv::countNonZero(diff > tolerance);
+        comparison.match = comparison.mismatched_values == 0;
+        return comparison;
+    }
+
+    cv::Mat make_input(const cv::Mat& source, int width, int height, int channels) {
+        cv::Mat input;
+        if (source.empty()) {
+            cv::RNG rng(12345);
+            input.create(height, width, CV_8UC(channels));
+            rng.fill(input, cv::RNG::UNIFORM, 0, 256);
+            return input;
+        }
+        cv::resize(source, input, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+        if (channels == 1) cv::cvtColor(input, input, cv::COLOR_BGR2GRAY);
+        return input;
+    }
+
+    std::vector<int> parse_int_list(const std::string& text) {
+        std::vector<int> values;
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            if (!item.empty()) values.push_back(std::stoi(item));
+        }
+        return values;
+    }
+
+    std::vector<cv::Size> parse_sizes(const std::string& text) {
+        std::vector<cv::Size> sizes;
+        std::stringstream stream(text);
+        std::string item;
+        while (std::getline(stream, item, ',')) {
+            size_t x = item.find('x');
+            if (x == std::string::npos) throw std::runtime_error("Invalid size '" + item + "', expected WIDTHxHEIGHT");
+            sizes.emplace_back(std::stoi(item.substr(0, x)), std::stoi(item.substr(x + 1)));
+        }
+        return sizes;
+    }
+
+    void write_timing(std::ostream& out, const char* key, const Timing& timing) {
+        out << "\"" << key << "\": {\"median_ms\": " << timing.median_ms << ", \"min_ms\": " << timing.min_ms
+            << ", \"mean_ms\": " << timing.mean_ms << ", \"repeats\": " << timing.repeats << "}";
+    }
+
+    void write_json(std::ostream& out, const std::vector<BenchResult>& results, int opencv_threads, const std::string& image_path) {
+        out << std::setprecision(6);
+        out << "{\n  \"benchmark\": \"filters\",\n";
+        out << "  \"opencv_version\": \"" << CV_VERSION << "\",\n";
+        out << "  \"opencv_threads\": " << opencv_threads << ",\n";
+        out << "  \"input\": \"" << (image_path.empty() ? "random" : image_path) << "\",\n";
+        out << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const BenchResult& r = results[i];
+            double megapixels = r.bench_case.width * r.bench_case.height / 1e6;
+            out << "    {\"kernel\": \"" << r.kernel << "\", \"width\": " << r.bench_case.width
+                << ", \"height\": " << r.bench_case.height << ", \"channels\": " << r.bench_case.channels
+                << ", \"kernel_size\": " << r.bench_case.kernel_size << ", ";
+            write_timing(out, "custom", r.custom);
+            out << ", ";
+            write_timing(out, "opencv", r.reference);
+            out << ", \"custom_mpix_per_s\": " << megapixels / (r.custom.median_ms / 1000.0)
+                << ", \"opencv_mpix_per_s\": " << megapixels / (r.reference.median_ms / 1000.0)
+                << ", \"slowdown\": " << r.custom.median_ms / r.reference.median_ms
+                << ", \"tolerance\": " << r.tolerance
+                << ", \"max_abs_diff\": " << r.comparison.max_abs_diff
+                << ", \"mean_abs_diff\": " << r.comparison.mean_abs_diff
+                << ", \"mismatched_values\": " << r.comparison.mismatched_values
+                << ", \"match\": " << (r.comparison.match ? "true" : "false") << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<cv::Size> sizes = {{320, 240}, {640, 480}, {1280, 720}};
+    std::vector<int> kernel_sizes = {3, 5, 9};
+    double min_time_s = 0.2;
+    int max_repeats = 50;
+    int opencv_threads = 1;
+    std::string image_path;
+    std::string kernel_filter;
+    std::string output_path = "filters_benchmark.json";
+    bool fail_on_mismatch = false;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--sizes" && i + 1 < argc) {
+                sizes = parse_sizes(argv[++i]);
+            } else if (arg == "--kernels" && i + 1 < argc) {
+                kernel_sizes = parse_int_list(argv[++i]);
+            } else if (arg == "--min-time" && i + 1 < argc) {
+                min_time_s = std::stod(argv[++i]);
+            } else if (arg == "--max-repeats" && i + 1 < argc) {
+                max_repeats = std::max(1, std::stoi(argv[++i]));
+            } else if (arg == "--opencv-threads" && i + 1 < argc) {
+                opencv_threads = std::stoi(argv[++i]);
+            } else if (arg == "--image" && i + 1 < argc) {
+                image_path = argv[++i];
+            } else if (arg == "--filter" && i + 1 < argc) {
+                kernel_filter = argv[++i];
+            } else if (arg == "--output" && i + 1 < argc) {
+                output_path = argv[++i];
+            } else if (arg == "--fail-on-mismatch") {
+                fail_on_mismatch = true;
+            } else {
+                std::cerr << "Unknown argument: " << arg << std::endl;
+                return 2;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 2;
+    }
+
+    // The custom kernels are single-threaded, so by default OpenCV is pinned to one thread as well.
+    cv::setNumThreads(opencv_threads);
+
+    cv::Mat source;
+    if (!image_path.empty()) {
+        source = cv::imread(image_path, cv::IMREAD_COLOR);
+        if (source.empty()) {
+            std::cerr << "Error: Unable to load " << image_path << std::endl;
+            return 2;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    std::cout << std::left << std::setw(20) << "kernel" << std::setw(11) << "size" << std::setw(4) << "ch"
+              << std::setw(4) << "k" << std::right << std::setw(12) << "custom ms" << std::setw(12) << "opencv ms"
+              << std::setw(10) << "slowdown" << std::setw(10) << "max diff" << "  match" << std::endl;
+
+    for (const KernelSpec& spec : kernel_specs()) {
+        if (!kernel_filter.empty() && spec.name.find(kernel_filter) == std::string::npos) continue;
+        std::vector<int> spec_kernel_sizes = spec.uses_kernel_size ? kernel_sizes : std::vector<int>{3};
+
+        for (const cv::Size& size : sizes) {
+            for (int channels : spec.channels) {
+                cv::Mat input = make_input(source, size.width, size.height, channels);
+                for (int kernel_size : spec_kernel_sizes) {
+                    BenchCase bench_case{size.width, size.height, channels, kernel_size, input};
+                    cv::Mat custom_output, reference_output;
+
+                    BenchResult result;
+                    result.kernel = spec.name;
+                    result.bench_case = bench_case;
+                    result.tolerance = spec.tolerance;
+                    result.custom = time_function([&] { return spec.custom(bench_case); }, min_time_s, max_repeats, custom_output);
+                    result.reference = time_function([&] { return spec.reference(bench_case); }, min_time_s, max_repeats, reference_output);
+                    result.comparison = compare_outputs(custom_output, reference_output, spec.tolerance);
+                    results.push_back(result);
+
+                    std::ostringstream size_text;
+                    size_text << size.width << "x" << size.height;
+                    std::cout << std::left << std::setw(20) << spec.name << std::setw(11) << size_text.str()
+                              << std::setw(4) << channels << std::setw(4) << kernel_size << std::right << std::fixed
+                              << std::setprecision(3) << std::setw(12) << result.custom.median_ms
+                              << std::setw(12) << result.reference.median_ms << std::setprecision(1)
+                              << std::setw(10) << result.custom.median_ms / result.reference.median_ms
+                              << std::setprecision(0) << std::setw(10) << result.comparison.max_abs_diff
+                              << "  " << (result.comparison.match ? "yes" : "NO") << std::defaultfloat << std::endl;
+                }
+            }
+        }
+    }
+
+    std::ofstream json(output_path);
+    if (!json) {
+        std::cerr << "Error: Unable to write " << output_path << std::endl;
+        return 2;
+    }
+    write_json(json, results, opencv_threads, image_path);
+    std::cout << "Results written to " << output_path << std::endl;
+
+    bool all_match = std::all_of(results.begin(), results.end(), [](const BenchResult& r) { return r.comparison.match; });
+    return fail_on_mismatch && !all_match ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+#include "../src/header/basic_image_operations.hpp"
+#include "../src/header/detection_server.hpp"
+#include <opencv2/opencv.hpp>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Load generator for the detection server (ImageProcessingCpp --serve PATH). Every connection sends its
+// requests back to back, waiting for each answer before the next request, and the report gives throughput
+// and request latency percentiles.
+//
+// Usage: server_load_generator --socket PATH [--images DIR] [--connections N] [--requests N] [--raw]
+
+namespace {
+    double percentile(std::vector<double> samples, double p) {
+        if (samples.empty()) return 0.0;
+        std::sort(samples.begin(), samples.end());
+        size_t rank = static_cast<size_t>(p / 100.0 * (samples.size() - 1) + 0.5);
+        return samples[std::min(rank, samples.size() - 1)];
+    }
+
+    std::vector<uint8_t> read_file(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string socket_path;
+    std::string image_dir = "../traffic_sign_images/vf";
+    int connections = 4;
+    int requests_per_connection = 100;
+    bool raw = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--images" && i + 1 < argc) {
+            image_dir = argv[++i];
+        } else if (arg == "--connections" && i + 1 < argc) {
+            connections = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--requests" && i + 1 < argc) {
+            requests_per_connection = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--raw") {
+            raw = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 2;
+        }
+    }
+    if (socket_path.empty()) {
+        std::cerr << "Usage: server_load_generator --socket PATH [--images DIR] [--connections N] [--requests N] [--raw]" << std::endl;
+        return 2;
+    }
+
+    // Encoded requests send the file bytes as they are; --raw sends decoded pixels and skips server-side decoding.
+    std::vector<std::vector<uint8_t>> encoded_images;
+    std::vector<cv::Mat> raw_images;
+    for (const auto& path : basic_ops::list_image_paths(image_dir, 100)) {
+        if (raw) {
+            cv::Mat image = cv::imread(path, cv::IMREAD_COLOR);
+            if (!image.empty()) raw_images.push_back(image);
+        } else {
+            encoded_images.push_back(read_file(path));
+        }
+    }
+    size_t image_count = raw ? raw_images.size() : encoded_images.size();
+    if (image_count == 0) {
+        std::cerr << "Error: No images found in " << image_dir << std::endl;
+        return 2;
+    }
+
+    std::vector<std::vector<double>> latencies(connections);
+    std::atomic<uint64_t> boxes{0};
+    std::atomic<uint64_t> errors{0};
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (int c = 0; c < connections; c++) {
+        clients.emplace_back([&, c] {
+            int fd = detection_server::connect_to(socket_path);
+            if (fd < 0) {
+                errors.fetch_add(requests_per_connection);
+                return;
+            }
+            detection_server::ResponseHeader header{};
+            std::vector<BoundingBox> bounding_boxes;
+            for (int r = 0; r < requests_per_connection; r++) {
+                size_t image = (static_cast<size_t>(c) * requests_per_connection + r) % image_count;
+                uint32_t request_id = static_cast<uint32_t>(c * requests_per_connection + r);
+                auto sent = std::chrono::steady_clock::now();
+                bool sent_ok = raw ? detection_server::send_request(fd, request_id, raw_images[image])
+                                   : detection_server::send_request(fd, request_id, encoded_images[image]);
+                if (!sent_ok || !detection_server::read_response(fd, header, bounding_boxes)) {
+                    errors.fetch_add(requests_per_connection - r);
+                    break;
+                }
+                latencies[c].push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sent).count());
+                if (header.status != detection_server::OK || header.request_id != request_id) errors.fetch_add(1);
+                boxes.fetch_add(bounding_boxes.size());
+            }
+            ::close(fd);
+        });
+    }
+    for (auto& client : clients) client.join();
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all_latencies;
+    for (const auto& connection_latencies : latencies) {
+        all_latencies.insert(all_latencies.end(), connection_latencies.begin(), connection_latencies.end());
+    }
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "requests: " << all_latencies.size() << ", errors: " << errors.load()
+              << ", boxes: " << boxes.load() << ", connections: " << connections << "\n";
+    std::cout << "throughput: " << all_latencies.size() / elapsed_s << " requests/s\n";
+    std::cout << "latency ms: p50 " << percentile(all_latencies, 50) << ", p90 " << percentile(all_latencies, 90)
+              << ", p99 " << percentile(all_latencies, 99) << ", max " << percentile(all_latencies, 100) << std::endl;
+    return errors.load() == 0 ? 0 : 1;
+}
@@ -1,5 +1,10 @@
 #include "header/basic_image_operations.hpp"
+#include "header/geometrical_image_operations.hpp"
+#include "header/image_loader.hpp"
+#include "header/profiling.hpp"
 #include "opencv2/opencv.hpp"
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <iostream>
 #include <filesystem>
@@ -7,6 +12,15 @@
 namespace fs = std::filesystem;
 
 namespace basic_ops {
+    namespace {
+        // PGM files are gray by definition, even when a decoder hands them out as BGR.
+        void fix_pgm_channels(cv::Mat& img, const std::string& image_path) {
+            if (img.channels() == 3 && fs::path(image_path).extension() == ".pgm") {
+                cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+            }
+        }
+    }
+
     cv::Mat create_image(int width, int height, int channels, int gray_value) {
         return cv::Mat(height, width, CV_8UC(channels), cv::Scalar(gray_value));
     }
@@ -25,6 +39,7 @@ namespace basic_ops {
     }
 
     cv::Mat load_image(const std::string& image_path, bool print) {
+        PROFILE_SCOPE("decode");
         if (!fs::exists(image_path)) {
             std::cerr << "Error: File not found." << std::endl;
             return {};
@@ -34,8 +49,59 @@ namespace basic_ops {
             std::cerr << "Error: Unable to load image." << std::endl;
             return {};
         }
-        if (img.channels() == 3 && fs::path(image_path).extension() == ".pgm") {
-            cv::cvtColor(img, img, cv::COLOR_BGR2GRAY);
+        fix_pgm_channels(img, image_path);
+        if (print) {
+            std::cout << "Image loaded from " << image_path << std::endl;
+        }
+        return img;
+    }
+
+    cv::Mat decode_image(const std::vector<uint8_t>& bytes, const std::string& image_path) {
+        PROFILE_SCOPE("decode");
+        cv::Mat img = cv::imdecode(bytes, cv::IMREAD_UNCHANGED);
+        if (img.empty()) {
+            std::cerr << "Error: Unable to load image." << std::endl;
+            return {};
+        }
+        fix_pgm_channels(img, image_path);
+        return img;
+    }
+
+    cv::Mat load_image_scaled(const std::string& image_path, int scale_factor, bool print) {
+        PROFILE_SCOPE("decode");
+        if (!fs::exists(image_path)) {
+            std::cerr << "Error: File not found." << std::endl;
+            return {};
+        }
+        std::string extension = fs::path(image_path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+        bool jpeg = extension == ".jpg" || extension == ".jpeg";
+
+        // Largest DCT-domain reduction that divides the requested factor; the rest is resized afterwards.
+        int decode_factor = 1;
+        int flags = cv::IMREAD_COLOR;
+        if (jpeg) {
+            if (scale_factor % 8 == 0) {
+                decode_factor = 8;
+                flags = cv::IMREAD_REDUCED_COLOR_8;
+            } else if (scale_factor % 4 == 0) {
+                decode_factor = 4;
+                flags = cv::IMREAD_REDUCED_COLOR_4;
+            } else if (scale_factor % 2 == 0) {
+                decode_factor = 2;
+                flags = cv::IMREAD_REDUCED_COLOR_2;
+            }
+        }
+
+        // load_image reads with IMREAD_UNCHANGED, which never applies EXIF rotation; keep the frames identical.
+        cv::Mat img = cv::imread(image_path, flags | cv::IMREAD_IGNORE_ORIENTATION);
+        if (img.empty()) {
+            std::cerr << "Error: Unable to load image." << std::endl;
+            return {};
+        }
+        int remaining_factor = std::max(1, scale_factor / decode_factor);
+        if (remaining_factor > 1) {
+            img = geo_ops::resize_image(img, img.cols / remaining_factor, img.rows / remaining_factor);
         }
         if (print) {
             std::cout << "Image loaded from " << image_path << std::endl;
@@ -43,17 +109,27 @@ namespace basic_ops {
         return img;
     }
 
-    std::vector<cv::Mat> load_images(const std::string& folder_path, int amount, bool print) {
-        std::vector<cv::Mat> images;
+    std::vector<std::string> list_image_paths(const std::string& folder_path, int amount) {
+        std::vector<std::string> image_paths;
         for (const auto& entry : fs::directory_iterator(folder_path)) {
-            std::string filename = entry.path().string();
             if (entry.path().extension() == ".jpg" || entry.path().extension() == ".jpeg" ||
                 entry.path().extension() == ".png" || entry.path().extension() == ".ppm" ||
                 entry.path().extension() == ".pgm") {
-                cv::Mat img = load_image(filename, print);
-                if (!img.empty()) images.push_back(img);
-                if (images.size() >= static_cast<size_t>(amount)) break;
-                }
+                image_paths.push_back(entry.path().string());
+            }
+        }
+        // directory_iterator order depends on the filesystem; sort so that amount always picks the same files.
+        std::sort(image_paths.begin(), image_paths.end());
+        if (amount >= 0 && image_paths.size() > static_cast<size_t>(amount)) image_paths.resize(amount);
+        return image_paths;
+    }
+
+    std::vector<cv::Mat> load_images(const std::string& folder_path, int amount, bool print) {
+        std::vector<cv::Mat> images;
+        ImageLoader loader(list_image_paths(folder_path, amount), 0, 8,
+                           [print](const std::string& image_path) { return load_image(image_path, print); });
+        while (std::optional<ImageLoader::LoadedImage> loaded = loader.next()) {
+            images.push_back(std::move(loaded->image));
         }
         return images;
     }
@@ -2,27 +2,20 @@
 #include <vector>
 #include <algorithm>
 #include <numeric> // for std::accumulate
+#include <cmath>
+#include "header/bounding_box.hpp"
+#include "header/profiling.hpp"
 
-struct BoundingBox {
-    int center_y;
-    int center_x;
-    std::vector<int> box_corners; // top, left, bottom, right
-    int box_height;
-    int box_width;
-    int box_area;
-    cv::Vec3b box_color; // BGR color
-    std::string box_shape;
-    int image_index;
-
-    BoundingBox(int y, int x, const std::vector<int> corners, int height, int width, int area, const cv::Vec3b& color, std::string shape, int index)
-        : center_y(y), center_x(x), box_corners(corners), box_height(height), box_width(width), box_area(area),  box_color(color), box_shape(shape), image_index(index) {}
-
-};
+BoundingBox::BoundingBox(int y, int x, std::vector<int> corners, int height, int width, int area,
+                         cv::Vec3b box_color, std::string shape, int image_index)
+    : center_y(y), center_x(x), box_corners(std::move(corners)), box_height(height), box_width(width), box_area(area),
+      box_color(box_color), box_shape(std::move(shape)), image_index(image_index) {}
 
 namespace bounding_box {
 
-    BoundingBox* create_bounding_box(const std::vector<cv::Point>& blob, int image_index, int min_box_area, int max_box_area, cv::Vec3b box_color) {
-        if (blob.empty()) return nullptr;
+    std::optional<BoundingBox> create_bounding_box(const std::vector<cv::Point>& blob, int image_index, int min_box_area,
+                                                   int max_box_area, const cv::Vec3b& box_color) {
+        if (blob.empty()) return std::nullopt;
 
         int left = std::numeric_limits<int>::max();
         int right = std::numeric_limits<int>::min();
@@ -54,30 +47,31 @@ namespace bounding_box {
         int height = bottom - top + 1;
         int area = width * height;
 
-        if (area < min_box_area || area > max_box_area) return nullptr;
+        if (area < min_box_area || area > max_box_area) return std::nullopt;
 
         double aspect_ratio = std::max(static_cast<double>(width)/height, static_cast<double>(height)/width);
-        if (aspect_ratio > 1.75) return nullptr;
+        if (aspect_ratio > 1.75) return std::nullopt;
 
         int center_y = (top + bottom) / 2;
         int center_x = (left + right) / 2;
 
         std::vector<int> box_corners = {top, left, bottom, right};
 
-        return new BoundingBox(center_y, center_x, box_corners, height, width, area, box_color, shape, image_index);
+        return BoundingBox(center_y, center_x, box_corners, height, width, area, box_color, shape, image_index);
     }
 
     std::vector<BoundingBox> create_bounding_boxes(const std::vector<std::vector<cv::Point>>& blobs,
                                                int image_index, int min_box_area, int max_box_area,
-                                               cv::Vec3b& box_color) {
+                                               const cv::Vec3b& box_color) {
+        PROFILE_SCOPE("create_bounding_boxes");
         std::vector<BoundingBox> bounding_boxes;
         for (const auto& blob : blobs) {
-            BoundingBox* bbox = create_bounding_box(blob, image_index, min_box_area, max_box_area, box_color);
-            if (bbox != nullptr) {
-                bounding_boxes.push_back(*bbox);
-                delete bbox;
+            std::optional<BoundingBox> bbox = create_bounding_box(blob, image_index, min_box_area, max_box_area, box_color);
+            if (bbox) {
+                bounding_boxes.push_back(std::move(*bbox));
             }
         }
+        PROFILE_ITEMS(bounding_boxes.size());
         return bounding_boxes;
     }
 
@@ -99,7 +93,17 @@ namespace bounding_box {
         return image;
     }
 
+    cv::Mat draw_bounding_boxes(const cv::Mat& image, const std::vector<BoundingBox>& bounding_boxes) {
+        if (bounding_boxes.empty()) return image;
+        cv::Mat annotated = image.clone();
+        for (const auto& bounding_box : bounding_boxes) {
+            draw_bounding_box(bounding_box, annotated);
+        }
+        return annotated;
+    }
+
     std::vector<BoundingBox> fuse_bounding_box_matches(const std::vector<BoundingBox>& boxes1, const std::vector<BoundingBox>& boxes2, int max_deviation) {
+        PROFILE_SCOPE("fuse_bounding_box_matches");
         std::vector<BoundingBox> new_boxes;
 
         for (const auto& box1 : boxes1) {
@@ -130,10 +134,12 @@ namespace bounding_box {
             }
         }
 
+        PROFILE_ITEMS(new_boxes.size());
         return new_boxes;
     }
 
     std::vector<BoundingBox> merge_duplicate_boxes(const std::vector<BoundingBox>& boxes, int max_deviation) {
+        PROFILE_SCOPE("merge_duplicate_boxes");
         std::vector<BoundingBox> merged_boxes;
         std::vector<bool> visited(boxes.size(), false);
 
@@ -190,6 +196,41 @@ namespace bounding_box {
             merged_boxes.emplace_back(avg_center_y, avg_center_x, avg_corners, avg_height, avg_width, avg_area, avg_color, avg_shape, image_index);
         }
 
+        PROFILE_ITEMS(merged_boxes.size());
         return merged_boxes;
     }
+
+    std::vector<cv::Rect> merge_overlapping_regions(std::vector<cv::Rect> regions) {
+        bool merged = true;
+        while (merged) {
+            merged = false;
+            for (size_t i = 0; i < regions.size() && !merged; i++) {
+                for (size_t j = i + 1; j < regions.size(); j++) {
+                    if ((regions[i] & regions[j]).area() > 0) {
+                        regions[i] |= regions[j];
+                        regions.erase(regions.begin() + j);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+        }
+        return regions;
+    }
+
+    std::vector<cv::Rect> padded_box_regions(const std::vector<BoundingBox>& boxes, const cv::Size& image_size, float padding) {
+        cv::Rect image_rect(0, 0, image_size.width, image_size.height);
+        std::vector<cv::Rect> regions;
+        for (const auto& box : boxes) {
+            int pad_x = static_cast<int>(std::ceil(box.box_width * padding));
+            int pad_y = static_cast<int>(std::ceil(box.box_height * padding));
+            // box_corners is top, left, bottom, right with inclusive bottom/right.
+            cv::Rect region(box.box_corners[1] - pad_x, box.box_corners[0] - pad_y,
+                            box.box_corners[3] - box.box_corners[1] + 1 + 2 * pad_x,
+                            box.box_corners[2] - box.box_corners[0] + 1 + 2 * pad_y);
+            region &= image_rect;
+            if (region.area() > 0) regions.push_back(region);
+        }
+        return merge_overlapping_regions(regions);
+    }
 }
@@ -0,0 +1,73 @@
+#include "header/box_tracker.hpp"
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+BoxTracker::BoxTracker(int max_misses, float match_gate, float velocity_smoothing)
+    : max_misses(max_misses), match_gate(match_gate), velocity_smoothing(velocity_smoothing) {}
+
+void BoxTracker::update(const std::vector<BoundingBox>& detections) {
+    // All (distance, track, detection) pairs inside the gate, closest first.
+    std::vector<std::tuple<float, size_t, size_t>> candidates;
+    for (size_t t = 0; t < active_tracks.size(); t++) {
+        const Track& track = active_tracks[t];
+        float steps = static_cast<float>(track.misses + 1);
+        float predicted_x = track.box.center_x + track.velocity_x * steps;
+        float predicted_y = track.box.center_y + track.velocity_y * steps;
+        float gate = match_gate * std::max(track.box.box_width, track.box.box_height);
+        for (size_t d = 0; d < detections.size(); d++) {
+            float distance = std::hypot(detections[d].center_x - predicted_x, detections[d].center_y - predicted_y);
+            if (distance <= gate) candidates.emplace_back(distance, t, d);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<bool> track_matched(active_tracks.size(), false);
+    std::vector<bool> detection_matched(detections.size(), false);
+    for (const auto& [distance, t, d] : candidates) {
+        if (track_matched[t] || detection_matched[d]) continue;
+        track_matched[t] = true;
+        detection_matched[d] = true;
+
+        Track& track = active_tracks[t];
+        float steps = static_cast<float>(track.misses + 1);
+        float observed_x = (detections[d].center_x - track.box.center_x) / steps;
+        float observed_y = (detections[d].center_y - track.box.center_y) / steps;
+        track.velocity_x = velocity_smoothing * observed_x + (1.0f - velocity_smoothing) * track.velocity_x;
+        track.velocity_y = velocity_smoothing * observed_y + (1.0f - velocity_smoothing) * track.velocity_y;
+        track.box = detections[d];
+        track.hits++;
+        track.misses = 0;
+    }
+
+    std::vector<Track> kept_tracks;
+    for (size_t t = 0; t < active_tracks.size(); t++) {
+        if (!track_matched[t]) active_tracks[t].misses++;
+        if (active_tracks[t].misses <= max_misses) kept_tracks.push_back(active_tracks[t]);
+    }
+    for (size_t d = 0; d < detections.size(); d++) {
+        if (!detection_matched[d]) kept_tracks.push_back({next_id++, detections[d], 0.0f, 0.0f, 1, 0});
+    }
+    active_tracks = std::move(kept_tracks);
+}
+
+void BoxTracker::clear() {
+    active_tracks.clear();
+}
+
+std::vector<cv::Rect> BoxTracker::predicted_regions(const cv::Size& image_size, float padding) const {
+    cv::Rect image_rect(0, 0, image_size.width, image_size.height);
+    std::vector<cv::Rect> regions;
+    for (const Track& track : active_tracks) {
+        float steps = static_cast<float>(track.misses + 1);
+        float center_x = track.box.center_x + track.velocity_x * steps;
+        float center_y = track.box.center_y + track.velocity_y * steps;
+        float half_width = track.box.box_width * (0.5f + padding);
+        float half_height = track.box.box_height * (0.5f + padding);
+        cv::Rect region(static_cast<int>(std::floor(center_x - half_width)), static_cast<int>(std::floor(center_y - half_height)),
+                        static_cast<int>(std::ceil(2.0f * half_width)) + 1, static_cast<int>(std::ceil(2.0f * half_height)) + 1);
+        region &= image_rect;
+        if (region.area() > 0) regions.push_back(region);
+    }
+    return bounding_box::merge_overlapping_regions(regions);
+}
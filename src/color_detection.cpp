@@ -1,16 +1,26 @@
 #include "header/color_detection.hpp"
-#include <stack>
+#include "header/scratch_buffers.hpp"
+#include "header/profiling.hpp"
 
 namespace cd {
     std::vector<std::vector<cv::Point>> get_blobs(cv::Mat mask) {
+        std::vector<std::vector<cv::Point>> blobs;
+        get_blobs(mask, blobs);
+        return blobs;
+    }
+
+    void get_blobs(const cv::Mat& mask, std::vector<std::vector<cv::Point>>& blobs) {
         CV_Assert(mask.type() == CV_8UC1);  // Expect a binary mask (1 channel)
+        PROFILE_SCOPE("get_blobs");
 
         int label = 1;
-        cv::Mat labels = cv::Mat::zeros(mask.size(), CV_32SC1);
+        cv::Mat labels = scratch::mat(scratch::BLOB_LABELS, mask.size(), CV_32SC1);
+        labels.setTo(cv::Scalar(0));
         int height = mask.rows;
         int width = mask.cols;
 
-        std::vector<std::vector<cv::Point>> blobs;
+        std::vector<cv::Point>& stack = scratch::vector<cv::Point>(scratch::BLOB_STACK);
+        scratch::resize_keeping_capacity(blobs, 0);
 
         //cv::imshow("mask", mask);
         //cv::waitKey(0);
@@ -18,14 +28,15 @@ namespace cd {
         for (int y = 0; y < height; y++) {
             for (int x = 0; x < width; x++) {
                 if (static_cast<int>(mask.at<uint8_t>(y, x)) == 255 && labels.at<int>(y, x) == 0) {
-                    std::stack<cv::Point> stack;
-                    std::vector<cv::Point> blob;
+                    scratch::resize_keeping_capacity(blobs, blobs.size() + 1);
+                    std::vector<cv::Point>& blob = blobs.back();
 
-                    stack.emplace(x, y);
+                    stack.clear();
+                    stack.emplace_back(x, y);
 
                     while (!stack.empty()) {
-                        cv::Point pt = stack.top();
-                        stack.pop();
+                        cv::Point pt = stack.back();
+                        stack.pop_back();
 
                         int cx = pt.x;
                         int cy = pt.y;
@@ -37,17 +48,16 @@ namespace cd {
                             labels.at<int>(cy, cx) = label;
                             blob.push_back(pt);
 
-                            stack.emplace(cx + 1, cy);
-                            stack.emplace(cx - 1, cy);
-                            stack.emplace(cx, cy + 1);
-                            stack.emplace(cx, cy - 1);
+                            stack.emplace_back(cx + 1, cy);
+                            stack.emplace_back(cx - 1, cy);
+                            stack.emplace_back(cx, cy + 1);
+                            stack.emplace_back(cx, cy - 1);
                         }
                     }
-                    blobs.push_back(blob);
                     ++label;
                 }
             }
         }
-        return blobs;
+        PROFILE_ITEMS(blobs.size());
     }
 }
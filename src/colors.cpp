@@ -1,91 +1,197 @@
 #include "header/colors.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define COLORS_HAVE_AVX2_KERNEL 1
+#endif
 
 namespace colors {
-    cv::Vec3b get_color_from_function(const std::function<bool(float, float, float)>& color_function) {
-        static std::function<bool(float, float, float)> red_func = is_strong_red;
-        static std::function<bool(float, float, float)> green_func = is_strong_green;
-        static std::function<bool(float, float, float)> yellow_func = is_strong_yellow;
-        static std::function<bool(float, float, float)> blue_func = is_strong_blue;
-
-        auto color_ptr = color_function.target<bool(*)(float, float, float)>();
-        auto red_ptr = red_func.target<bool(*)(float, float, float)>();
-        auto green_ptr = green_func.target<bool(*)(float, float, float)>();
-        auto yellow_ptr = yellow_func.target<bool(*)(float, float, float)>();
-        auto blue_ptr = blue_func.target<bool(*)(float, float, float)>();
-
-        if (color_ptr && red_ptr && *color_ptr == *red_ptr) {
-            return cv::Vec3b(0, 0, 255); // Red
+    namespace {
+        // Fixed-point HSV as done by OpenCV for 8-bit images, so results match cv::cvtColor exactly.
+        const int hsv_shift = 12;
+
+        struct HsvTables {
+            int sdiv[256];
+            int hdiv[256];
+
+            HsvTables() {
+                sdiv[0] = hdiv[0] = 0;
+                for (int i = 1; i < 256; ++i) {
+                    sdiv[i] = cv::saturate_cast<int>((255 << hsv_shift) / (1.0 * i));
+                    hdiv[i] = cv::saturate_cast<int>((180 << hsv_shift) / (6.0 * i));
+                }
+            }
+        };
+
+        const HsvTables& hsv_tables() {
+            static const HsvTables tables;
+            return tables;
         }
-        if (color_ptr && green_ptr && *color_ptr == *green_ptr) {
-            return cv::Vec3b(0, 255, 0); // Green
+
+        inline void bgr_to_hsv_pixel(int b, int g, int r, const HsvTables& tables, uchar& h_out, uchar& s_out, uchar& v_out) {
+            int v = std::max(b, std::max(g, r));
+            int vmin = std::min(b, std::min(g, r));
+            int diff = v - vmin;
+            int vr = v == r ? -1 : 0;
+            int vg = v == g ? -1 : 0;
+
+            int s = (diff * tables.sdiv[v] + (1 << (hsv_shift - 1))) >> hsv_shift;
+            int h = (vr & (g - b)) + (~vr & ((vg & (b - r + 2 * diff)) + (~vg & (r - g + 4 * diff))));
+            h = (h * tables.hdiv[diff] + (1 << (hsv_shift - 1))) >> hsv_shift;
+            h += h < 0 ? 180 : 0;
+
+            h_out = cv::saturate_cast<uchar>(h);
+            s_out = static_cast<uchar>(s);
+            v_out = static_cast<uchar>(v);
+        }
+
+        void bgr_to_hsv_row(const uchar* bgr, uchar* h, uchar* s, uchar* v, int x, int width, const HsvTables& tables) {
+            for (; x < width; ++x) {
+                bgr_to_hsv_pixel(bgr[3 * x], bgr[3 * x + 1], bgr[3 * x + 2], tables, h[x], s[x], v[x]);
+            }
+        }
+
+#ifdef COLORS_HAVE_AVX2_KERNEL
+        __attribute__((target("avx2")))
+        inline void hsv_avx2_8(__m256i b, __m256i g, __m256i r, const HsvTables& tables,
+                               __m256i& h_out, __m256i& s_out, __m256i& v_out) {
+            const __m256i round = _mm256_set1_epi32(1 << (hsv_shift - 1));
+            __m256i v = _mm256_max_epi32(b, _mm256_max_epi32(g, r));
+            __m256i vmin = _mm256_min_epi32(b, _mm256_min_epi32(g, r));
+            __m256i diff = _mm256_sub_epi32(v, vmin);
+            __m256i vr = _mm256_cmpeq_epi32(v, r);
+            __m256i vg = _mm256_cmpeq_epi32(v, g);
+
+            __m256i sdiv = _mm256_i32gather_epi32(tables.sdiv, v, 4);
+            __m256i s = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(diff, sdiv), round), hsv_shift);
+
+            __m256i h_r = _mm256_sub_epi32(g, b);
+            __m256i h_g = _mm256_add_epi32(_mm256_sub_epi32(b, r), _mm256_slli_epi32(diff, 1));
+            __m256i h_b = _mm256_add_epi32(_mm256_sub_epi32(r, g), _mm256_slli_epi32(diff, 2));
+            __m256i h = _mm256_blendv_epi8(_mm256_blendv_epi8(h_b, h_g, vg), h_r, vr);
+
+            __m256i hdiv = _mm256_i32gather_epi32(tables.hdiv, diff, 4);
+            h = _mm256_srai_epi32(_mm256_add_epi32(_mm256_mullo_epi32(h, hdiv), round), hsv_shift);
+            h = _mm256_add_epi32(h, _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_setzero_si256(), h), _mm256_set1_epi32(180)));
+
+            h_out = h;
+            s_out = s;
+            v_out = v;
         }
-        if (color_ptr && yellow_ptr && *color_ptr == *yellow_ptr) {
-            return cv::Vec3b(0, 255, 255); // Yellow
+
+        __attribute__((target("avx2")))
+        inline __m128i pack_16_u8(__m256i lo, __m256i hi) {
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+            return _mm_packus_epi16(_mm256_castsi256_si128(packed), _mm256_extracti128_si256(packed, 1));
         }
-        if (color_ptr && blue_ptr && *color_ptr == *blue_ptr) {
-            return cv::Vec3b(255, 0, 0); // Blue
+
+        // Converts 16 pixels per iteration: the interleaved BGR bytes are split into planes with byte shuffles,
+        // widened to 32-bit lanes and run through the same fixed-point math as the scalar path.
+        __attribute__((target("avx2")))
+        void bgr_to_hsv_row_avx2(const uchar* bgr, uchar* h, uchar* s, uchar* v, int width, const HsvTables& tables) {
+            const __m128i b0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+            const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+            const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+            const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+            const __m128i r0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+            const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+            const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+            int x = 0;
+            for (; x + 16 <= width; x += 16) {
+                const uchar* src = bgr + 3 * x;
+                __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+                __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+
+                __m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, b0), _mm_shuffle_epi8(a1, b1)), _mm_shuffle_epi8(a2, b2));
+                __m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, g0), _mm_shuffle_epi8(a1, g1)), _mm_shuffle_epi8(a2, g2));
+                __m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, r0), _mm_shuffle_epi8(a1, r1)), _mm_shuffle_epi8(a2, r2));
+
+                __m256i h_lo, s_lo, v_lo, h_hi, s_hi, v_hi;
+                hsv_avx2_8(_mm256_cvtepu8_epi32(b), _mm256_cvtepu8_epi32(g), _mm256_cvtepu8_epi32(r),
+                           tables, h_lo, s_lo, v_lo);
+                hsv_avx2_8(_mm256_cvtepu8_epi32(_mm_srli_si128(b, 8)), _mm256_cvtepu8_epi32(_mm_srli_si128(g, 8)),
+                           _mm256_cvtepu8_epi32(_mm_srli_si128(r, 8)), tables, h_hi, s_hi, v_hi);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(h + x), pack_16_u8(h_lo, h_hi));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(s + x), pack_16_u8(s_lo, s_hi));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(v + x), pack_16_u8(v_lo, v_hi));
+            }
+            bgr_to_hsv_row(bgr, h, s, v, x, width, tables);
         }
 
-        return cv::Vec3b(0, 0, 0); // Default black if unknown
+        bool cpu_has_avx2() {
+            static const bool has_avx2 = __builtin_cpu_supports("avx2");
+            return has_avx2;
+        }
+#endif
     }
 
     cv::Vec3f bgr_to_hsv(const cv::Vec3b& bgr_pixel) {
-        cv::Mat3b bgr(1, 1, bgr_pixel);
-        cv::Mat3b hsv;
-        cv::cvtColor(bgr, hsv, cv::COLOR_BGR2HSV);
-        cv::Vec3b hsv_pixel = hsv.at<cv::Vec3b>(0, 0);
+        uchar h_pixel, s_pixel, v_pixel;
+        bgr_to_hsv_pixel(bgr_pixel[0], bgr_pixel[1], bgr_pixel[2], hsv_tables(), h_pixel, s_pixel, v_pixel);
 
-        float h = hsv_pixel[0] * 2.0f;
-        float s = hsv_pixel[1] / 255.0f;
-        float v = hsv_pixel[2] / 255.0f;
+        float h = h_pixel * 2.0f;
+        float s = s_pixel / 255.0f;
+        float v = v_pixel / 255.0f;
 
         return cv::Vec3f(h, s, v);
     }
 
-    bool is_strong_red(float h, float s, float v) {
-        bool is_hue_red = (h >= 340.0f || h <= 20.0f);
-        bool is_saturated = (s >= 0.3f);
-        bool is_bright_enough = (v >= 0.1f);
-        return is_hue_red && is_saturated && is_bright_enough;
-    }
-
-    bool is_strong_green(float h, float s, float v) {
-        bool is_hue_green = (h >= 105.0f && h <= 135.0f);
-        bool is_saturated = (s >= 0.3f);
-        bool is_bright_enough = (v >= 0.1f);
-        return is_hue_green && is_saturated && is_bright_enough;
-    }
+    HsvPlanes bgr_to_hsv_planes(const cv::Mat& image) {
+        CV_Assert(image.type() == CV_8UC3);
+        PROFILE_SCOPE("bgr_to_hsv_planes");
 
-    bool is_strong_blue(float h, float s, float v) {
-        bool is_hue_blue = (h >= 200.0f && h <= 240.0f);
-        bool is_saturated = (s >= 0.4f);
-        bool is_bright_enough = (v >= 0.2f);
-        return is_hue_blue && is_saturated && is_bright_enough;
-    }
+        const HsvTables& tables = hsv_tables();
+        HsvPlanes hsv;
+        hsv.h.create(image.rows, image.cols, CV_8U);
+        hsv.s.create(image.rows, image.cols, CV_8U);
+        hsv.v.create(image.rows, image.cols, CV_8U);
 
-    bool is_strong_yellow(float h, float s, float v) {
-        bool is_hue_yellow = (h >= 35.0f && h <= 65.0f);
-        bool is_saturated = (s >= 0.5f);
-        bool is_bright_enough = (v >= 0.3f);
-        return is_hue_yellow && is_saturated && is_bright_enough;
+        for (int y = 0; y < image.rows; ++y) {
+            const uchar* row_ptr = image.ptr<uchar>(y);
+            uchar* h_ptr = hsv.h.ptr<uchar>(y);
+            uchar* s_ptr = hsv.s.ptr<uchar>(y);
+            uchar* v_ptr = hsv.v.ptr<uchar>(y);
+#ifdef COLORS_HAVE_AVX2_KERNEL
+            if (cpu_has_avx2()) {
+                bgr_to_hsv_row_avx2(row_ptr, h_ptr, s_ptr, v_ptr, image.cols, tables);
+                continue;
+            }
+#endif
+            bgr_to_hsv_row(row_ptr, h_ptr, s_ptr, v_ptr, 0, image.cols, tables);
+        }
+        return hsv;
     }
 
     cv::Mat get_mask(const cv::Mat& image, std::function<bool(float, float, float)> color_function) {
-        CV_Assert(image.type() == CV_8UC3);
+        return get_mask(bgr_to_hsv_planes(image), color_function);
+    }
 
-        int height = image.rows;
-        int width = image.cols;
+    cv::Mat get_mask(const HsvPlanes& hsv, const std::function<bool(float, float, float)>& color_function) {
+        PROFILE_SCOPE("get_mask");
+        int height = hsv.h.rows;
+        int width = hsv.h.cols;
         cv::Mat mask(height, width, CV_8U, cv::Scalar(0));
 
         for (int y = 0; y < height; ++y) {
-            const cv::Vec3b* row_ptr = image.ptr<cv::Vec3b>(y);
+            const uchar* h_ptr = hsv.h.ptr<uchar>(y);
+            const uchar* s_ptr = hsv.s.ptr<uchar>(y);
+            const uchar* v_ptr = hsv.v.ptr<uchar>(y);
             uchar* mask_ptr = mask.ptr<uchar>(y);
 
             for (int x = 0; x < width; ++x) {
-                cv::Vec3f hsv = bgr_to_hsv(row_ptr[x]);
-                float h = hsv[0];
-                float s = hsv[1];
-                float v = hsv[2];
+                float h = h_ptr[x] * 2.0f;
+                float s = s_ptr[x] / 255.0f;
+                float v = v_ptr[x] / 255.0f;
 
                 if (color_function(h, s, v)) {
                     mask_ptr[x] = 255;
@@ -95,4 +201,97 @@ namespace colors {
 
         return mask;
     }
+
+    namespace {
+        const char color_lut_magic[4] = {'C', 'L', 'U', 'T'};
+        // Bump whenever a color predicate or the class bits change, so stale LUT files are rebuilt.
+        const uint32_t color_lut_version = 1;
+        const size_t color_lut_size = size_t(1) << 24;
+
+        std::vector<uint8_t>& color_lut_storage() {
+            static std::vector<uint8_t> lut;
+            return lut;
+        }
+
+        std::once_flag color_lut_once;
+
+        std::vector<uint8_t> build_color_lut() {
+            PROFILE_SCOPE("build_color_lut");
+            // Every BGR value appears exactly once in a 4096x4096 image, so one cvtColor converts the whole cube.
+            cv::Mat bgr(4096, 4096, CV_8UC3);
+            for (int y = 0; y < bgr.rows; ++y) {
+                cv::Vec3b* row_ptr = bgr.ptr<cv::Vec3b>(y);
+                for (int x = 0; x < bgr.cols; ++x) {
+                    uint32_t index = static_cast<uint32_t>(y) * 4096 + x;
+                    row_ptr[x] = cv::Vec3b(static_cast<uchar>(index >> 16), static_cast<uchar>(index >> 8), static_cast<uchar>(index));
+                }
+            }
+            HsvPlanes hsv = bgr_to_hsv_planes(bgr);
+
+            std::vector<uint8_t> lut(color_lut_size, 0);
+            for (int y = 0; y < bgr.rows; ++y) {
+                const uchar* h_ptr = hsv.h.ptr<uchar>(y);
+                const uchar* s_ptr = hsv.s.ptr<uchar>(y);
+                const uchar* v_ptr = hsv.v.ptr<uchar>(y);
+                for (int x = 0; x < bgr.cols; ++x) {
+                    float h = h_ptr[x] * 2.0f;
+                    float s = s_ptr[x] / 255.0f;
+                    float v = v_ptr[x] / 255.0f;
+
+                    uint8_t label = 0;
+                    if (StrongRed::matches(h, s, v)) label |= StrongRed::lut_bit;
+                    if (StrongGreen::matches(h, s, v)) label |= StrongGreen::lut_bit;
+                    if (StrongBlue::matches(h, s, v)) label |= StrongBlue::lut_bit;
+                    if (StrongYellow::matches(h, s, v)) label |= StrongYellow::lut_bit;
+                    lut[static_cast<size_t>(y) * 4096 + x] = label;
+                }
+            }
+            return lut;
+        }
+    }
+
+    const std::vector<uint8_t>& get_color_lut() {
+        std::call_once(color_lut_once, [] {
+            if (color_lut_storage().empty()) {
+                color_lut_storage() = build_color_lut();
+            }
+        });
+        return color_lut_storage();
+    }
+
+    bool load_color_lut(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        char magic[4];
+        uint32_t version = 0;
+        file.read(magic, sizeof(magic));
+        file.read(reinterpret_cast<char*>(&version), sizeof(version));
+        if (!file || std::memcmp(magic, color_lut_magic, sizeof(magic)) != 0 || version != color_lut_version) {
+            std::cerr << "Error: " << path << " is not a compatible color LUT." << std::endl;
+            return false;
+        }
+
+        std::vector<uint8_t> lut(color_lut_size);
+        file.read(reinterpret_cast<char*>(lut.data()), static_cast<std::streamsize>(lut.size()));
+        if (!file) {
+            std::cerr << "Error: color LUT " << path << " is truncated." << std::endl;
+            return false;
+        }
+        color_lut_storage() = std::move(lut);
+        return true;
+    }
+
+    bool save_color_lut(const std::string& path) {
+        const std::vector<uint8_t>& lut = get_color_lut();
+        std::ofstream file(path, std::ios::binary);
+        file.write(color_lut_magic, sizeof(color_lut_magic));
+        file.write(reinterpret_cast<const char*>(&color_lut_version), sizeof(color_lut_version));
+        file.write(reinterpret_cast<const char*>(lut.data()), static_cast<std::streamsize>(lut.size()));
+        if (!file) {
+            std::cerr << "Error: Unable to save color LUT to " << path << std::endl;
+            return false;
+        }
+        return true;
+    }
 }
@@ -0,0 +1,239 @@
+#include "header/detection_server.hpp"
+#include "header/result_stream.hpp"
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+namespace detection_server {
+    namespace {
+        bool read_fully(int fd, void* data, size_t size) {
+            char* bytes = static_cast<char*>(data);
+            while (size > 0) {
+                ssize_t n = ::recv(fd, bytes, size, 0);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                bytes += n;
+                size -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        bool write_fully(int fd, const void* data, size_t size) {
+            const char* bytes = static_cast<const char*>(data);
+            while (size > 0) {
+                ssize_t n = ::send(fd, bytes, size, MSG_NOSIGNAL);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) return false;
+                bytes += n;
+                size -= static_cast<size_t>(n);
+            }
+            return true;
+        }
+
+        sockaddr_un socket_address(const std::string& socket_path) {
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if (socket_path.size() >= sizeof(address.sun_path)) {
+                throw std::runtime_error("Socket path too long: " + socket_path);
+            }
+            std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+            return address;
+        }
+    }
+
+    struct Server::Connection {
+        explicit Connection(int fd) : fd(fd) {}
+        ~Connection() { ::close(fd); }
+
+        int fd;
+        std::mutex write_mutex;
+        std::atomic<bool> finished{false};
+        std::thread reader;
+    };
+
+    Server::Server(const Detector& detector, ServerOptions options)
+        : detector(detector), options(std::move(options)), pending(this->options.max_pending) {}
+
+    Server::~Server() {
+        stop();
+    }
+
+    void Server::run() {
+        // A socket left behind by an earlier server is replaced; anything else at the path is left alone.
+        struct stat existing{};
+        if (::lstat(options.socket_path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                throw std::runtime_error(options.socket_path + " exists and is not a socket");
+            }
+            ::unlink(options.socket_path.c_str());
+        }
+        int listen_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listen_fd < 0) throw std::runtime_error("Unable to create socket");
+        sockaddr_un address = socket_address(options.socket_path);
+        if (::bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listen_fd, 64) != 0) {
+            ::close(listen_fd);
+            throw std::runtime_error("Unable to listen on " + options.socket_path + ": " + std::strerror(errno));
+        }
+        std::cout << "Detection server listening on " << options.socket_path << std::endl;
+
+        std::thread batcher([this] { batch_loop(); });
+
+        while (!stopping.load()) {
+            pollfd listen_poll{listen_fd, POLLIN, 0};
+            if (::poll(&listen_poll, 1, 200) <= 0) continue;
+            int client_fd = ::accept(listen_fd, nullptr, nullptr);
+            if (client_fd < 0) continue;
+
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            // Reap readers of connections that have hung up.
+            for (auto it = connections.begin(); it != connections.end();) {
+                if ((*it)->finished.load()) {
+                    (*it)->reader.join();
+                    it = connections.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+            auto connection = std::make_shared<Connection>(client_fd);
+            connection->reader = std::thread([this, connection] { read_loop(connection); });
+            connections.push_back(connection);
+        }
+
+        ::close(listen_fd);
+        ::unlink(options.socket_path.c_str());
+
+        // Wake the readers, let the batcher answer what was already accepted, then wait for everything.
+        {
+            std::lock_guard<std::mutex> lock(connections_mutex);
+            for (auto& connection : connections) ::shutdown(connection->fd, SHUT_RD);
+            for (auto& connection : connections) connection->reader.join();
+            connections.clear();
+        }
+        pending.close();
+        batcher.join();
+    }
+
+    void Server::read_loop(std::shared_ptr<Connection> connection) {
+        RequestHeader header{};
+        std::vector<uint8_t> payload;
+        while (read_fully(connection->fd, &header, sizeof(header))) {
+            if (std::memcmp(header.magic, "TSRQ", 4) != 0 || header.payload_size > options.max_payload_bytes) {
+                std::cerr << "Detection server: malformed request, closing connection" << std::endl;
+                break;
+            }
+            payload.resize(header.payload_size);
+            if (!read_fully(connection->fd, payload.data(), payload.size())) break;
+
+            PendingRequest request{connection, header.request_id, OK, cv::Mat(), std::chrono::steady_clock::now()};
+            if (header.width == 0) {
+                request.image = cv::imdecode(payload, cv::IMREAD_COLOR);
+            } else if (header.width > 0 && header.height > 0 &&
+                       static_cast<size_t>(header.width) * header.height * 3 == payload.size()) {
+                request.image = cv::Mat(header.height, header.width, CV_8UC3, payload.data()).clone();
+            }
+            if (request.image.empty()) request.status = BAD_IMAGE;
+            if (!pending.push(std::move(request))) break;
+        }
+        connection->finished.store(true);
+    }
+
+    void Server::batch_loop() {
+        while (std::optional<PendingRequest> first = pending.pop()) {
+            std::vector<PendingRequest> batch;
+            auto deadline = first->received + std::chrono::milliseconds(options.max_batch_latency_ms);
+            batch.push_back(std::move(*first));
+            while (batch.size() < options.max_batch_size) {
+                std::optional<PendingRequest> next = pending.pop_until(deadline);
+                if (!next) break;
+                batch.push_back(std::move(*next));
+            }
+
+            std::vector<cv::Mat> images;
+            for (const auto& request : batch) images.push_back(request.image);
+            std::vector<std::vector<BoundingBox>> results;
+            try {
+                results = detector.detect_batch(images);
+            } catch (const std::exception& e) {
+                std::cerr << "Detection server: " << e.what() << std::endl;
+                for (auto& request : batch) {
+                    if (request.status == OK) request.status = DETECTION_FAILED;
+                }
+                results.assign(batch.size(), {});
+            }
+            batch_count.fetch_add(1);
+
+            for (size_t i = 0; i < batch.size(); i++) {
+                respond(batch[i], results[i]);
+            }
+        }
+    }
+
+    void Server::respond(const PendingRequest& request, const std::vector<BoundingBox>& bounding_boxes) {
+        ResponseHeader header{};
+        std::memcpy(header.magic, "TSRS", 4);
+        header.request_id = request.request_id;
+        header.status = request.status;
+        header.box_count = request.status == OK ? static_cast<uint32_t>(bounding_boxes.size()) : 0;
+
+        std::vector<char> message(sizeof(header) + header.box_count * sizeof(result_stream::BoxRecord));
+        std::memcpy(message.data(), &header, sizeof(header));
+        for (uint32_t i = 0; i < header.box_count; i++) {
+            result_stream::BoxRecord record = result_stream::to_box_record(bounding_boxes[i], request.request_id, 0);
+            std::memcpy(message.data() + sizeof(header) + i * sizeof(record), &record, sizeof(record));
+        }
+
+        std::lock_guard<std::mutex> lock(request.connection->write_mutex);
+        // A client that has gone away just misses its answer.
+        write_fully(request.connection->fd, message.data(), message.size());
+        served_count.fetch_add(1);
+    }
+
+    int connect_to(const std::string& socket_path) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        sockaddr_un address = socket_address(socket_path);
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            ::close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool send_request(int fd, uint32_t request_id, const std::vector<uint8_t>& encoded_image) {
+        RequestHeader header{};
+        std::memcpy(header.magic, "TSRQ", 4);
+        header.request_id = request_id;
+        header.payload_size = static_cast<uint32_t>(encoded_image.size());
+        return write_fully(fd, &header, sizeof(header)) && write_fully(fd, encoded_image.data(), encoded_image.size());
+    }
+
+    bool send_request(int fd, uint32_t request_id, const cv::Mat& bgr_image) {
+        CV_Assert(bgr_image.type() == CV_8UC3);
+        cv::Mat packed = bgr_image.isContinuous() ? bgr_image : bgr_image.clone();
+        RequestHeader header{};
+        std::memcpy(header.magic, "TSRQ", 4);
+        header.request_id = request_id;
+        header.width = packed.cols;
+        header.height = packed.rows;
+        header.payload_size = static_cast<uint32_t>(packed.total() * packed.elemSize());
+        return write_fully(fd, &header, sizeof(header)) && write_fully(fd, packed.data, header.payload_size);
+    }
+
+    bool read_response(int fd, ResponseHeader& header, std::vector<BoundingBox>& bounding_boxes) {
+        bounding_boxes.clear();
+        if (!read_fully(fd, &header, sizeof(header)) || std::memcmp(header.magic, "TSRS", 4) != 0) return false;
+        for (uint32_t i = 0; i < header.box_count; i++) {
+            result_stream::BoxRecord record{};
+            if (!read_fully(fd, &record, sizeof(record))) return false;
+            bounding_boxes.push_back(result_stream::from_box_record(record));
+        }
+        return true;
+    }
+}
@@ -0,0 +1,94 @@
+#include "header/detector.hpp"
+#include "header/basic_image_operations.hpp"
+#include "header/profiling.hpp"
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+Detector::Detector(const pipeline_config::PipelineConfig& config, size_t num_threads)
+    : pool(std::make_unique<ThreadPool>(num_threads)), graph(config, pool.get()), config_hash(ResultCache::hash_config(config)) {}
+
+Detector::Detector(const std::string& config_path, size_t num_threads)
+    : Detector(pipeline_config::load_config(config_path), num_threads) {}
+
+cv::Mat Detector::wrap_buffer(const ImageBuffer& buffer) {
+    if (buffer.data == nullptr || buffer.width <= 0 || buffer.height <= 0) {
+        throw std::invalid_argument("Detector: empty image buffer");
+    }
+    size_t stride = buffer.stride != 0 ? buffer.stride : static_cast<size_t>(buffer.width) * 3;
+    // The graph only reads its source image, so dropping const here is safe.
+    return cv::Mat(buffer.height, buffer.width, CV_8UC3, const_cast<uint8_t*>(buffer.data), stride);
+}
+
+std::vector<BoundingBox> Detector::detect(const cv::Mat& image, int image_index) const {
+    if (image.empty()) return {};
+    return graph.run(image, image_index).bounding_boxes;
+}
+
+std::vector<BoundingBox> Detector::detect(const ImageBuffer& buffer, int image_index) const {
+    return detect(wrap_buffer(buffer), image_index);
+}
+
+std::vector<pipeline_graph::GraphResult> Detector::run_batch(const std::vector<cv::Mat>& images, int first_image_index) const {
+    std::vector<pipeline_graph::GraphResult> results(images.size());
+    pool->parallel_for(images.size(), [&](size_t i) {
+        if (!images[i].empty()) {
+            results[i] = graph.run(images[i], first_image_index + static_cast<int>(i));
+        }
+    });
+    return results;
+}
+
+std::vector<pipeline_graph::GraphResult> Detector::run_files(const std::vector<std::string>& image_paths, int first_image_index,
+                                                             ResultCache* cache) const {
+    std::vector<pipeline_graph::GraphResult> results(image_paths.size());
+    pool->parallel_for(image_paths.size(), [&](size_t i) {
+        int image_index = first_image_index + static_cast<int>(i);
+        if (cache == nullptr) {
+            cv::Mat image = basic_ops::load_image(image_paths[i], true);
+            if (!image.empty()) {
+                results[i] = graph.run(image, image_index);
+            }
+            return;
+        }
+
+        // The file is read once: its bytes are hashed for the cache key and, on a miss, decoded from memory.
+        std::ifstream file(image_paths[i], std::ios::binary);
+        std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (bytes.empty()) {
+            cache->record_miss();
+            std::cerr << "Error: Unable to read " << image_paths[i] << std::endl;
+            return;
+        }
+        uint64_t image_hash = ResultCache::hash_bytes(bytes.data(), bytes.size());
+        if (std::optional<ResultCache::Entry> cached = cache->lookup(image_hash, config_hash, image_index)) {
+            results[i].bounding_boxes = std::move(cached->bounding_boxes);
+            results[i].stage_boxes = std::move(cached->stage_boxes);
+            return;
+        }
+
+        cv::Mat image = basic_ops::decode_image(bytes, image_paths[i]);
+        if (image.empty()) return;
+        results[i] = graph.run(image, image_index, true);
+        cache->store(image_hash, config_hash, {results[i].bounding_boxes, results[i].stage_boxes});
+    });
+    return results;
+}
+
+std::vector<std::vector<BoundingBox>> Detector::detect_batch(const std::vector<cv::Mat>& images, int first_image_index) const {
+    std::vector<std::vector<BoundingBox>> bounding_boxes(images.size());
+    pool->parallel_for(images.size(), [&](size_t i) {
+        bounding_boxes[i] = detect(images[i], first_image_index + static_cast<int>(i));
+    });
+    return bounding_boxes;
+}
+
+std::vector<std::vector<BoundingBox>> Detector::detect_batch(const std::vector<ImageBuffer>& buffers, int first_image_index) const {
+    std::vector<cv::Mat> images;
+    images.reserve(buffers.size());
+    for (const auto& buffer : buffers) {
+        images.push_back(wrap_buffer(buffer));
+    }
+    return detect_batch(images, first_image_index);
+}
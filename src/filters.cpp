@@ -1,4 +1,7 @@
 #include "header/filters.hpp"
+#include "header/convolution.hpp"
+#include "header/morphology.hpp"
+#include "header/scratch_buffers.hpp"
 #include <cmath>
 #include <vector>
 #include <algorithm>
@@ -30,73 +33,107 @@ namespace filters {
         return result;
     }
 
+    namespace {
+        // The padded copies below live in a per-thread scratch buffer (scratch_buffers.hpp), so repeated
+        // calls on same-sized images do not allocate.
+        cv::Mat padded_scratch(const cv::Mat& image, int pad) {
+            return scratch::mat(scratch::FILTER_PADDED, image.rows + 2 * pad, image.cols + 2 * pad, image.type());
+        }
+    }
+
+    // Separable running sums: a sum per column and channel is slid down the image and the output row is a
+    // sum slid along those, so every pixel costs the same for any kernelDim. Pixels outside the image count
+    // as 0 (BORDER_CONSTANT).
     cv::Mat blurFilter(const cv::Mat& image, int kernelDim, int kernelIntensity) {
+        CV_Assert(image.depth() == CV_8U && kernelDim > 0);
         int pad = kernelDim / 2;
-        cv::Mat padded;
-        cv::copyMakeBorder(image, padded, pad, pad, pad, pad, cv::BORDER_CONSTANT, 0);
+        int rows = image.rows, cols = image.cols, channels = image.channels();
         cv::Mat output(image.size(), image.type());
 
-        for (int y = 0; y < image.rows; ++y) {
-            for (int x = 0; x < image.cols; ++x) {
-                for (int c = 0; c < image.channels(); ++c) {
-                    float sum = 0.0f;
-                    for (int ky = 0; ky < kernelDim; ++ky) {
-                        for (int kx = 0; kx < kernelDim; ++kx) {
-                            sum += padded.at<cv::Vec3b>(y + ky, x + kx)[c];
-                        }
-                    }
-                    output.at<cv::Vec3b>(y, x)[c] = static_cast<uchar>(sum / kernelIntensity);
+        std::vector<uint32_t>& column_sums = scratch::vector<uint32_t>(scratch::FILTER_SUMS);
+        column_sums.assign(static_cast<size_t>(cols) * channels, 0);
+        // The window of output row y covers rows y - pad ... y - pad + kernelDim - 1.
+        for (int r = 0; r < std::min(rows, kernelDim - pad); ++r) {
+            const uchar* row = image.ptr<uchar>(r);
+            for (size_t i = 0; i < column_sums.size(); ++i) column_sums[i] += row[i];
+        }
+
+        uint32_t sums[CV_CN_MAX];
+        for (int y = 0; y < rows; ++y) {
+            uchar* out = output.ptr<uchar>(y);
+            for (int c = 0; c < channels; ++c) {
+                sums[c] = 0;
+                for (int x = 0; x < std::min(cols, kernelDim - pad); ++x) sums[c] += column_sums[x * channels + c];
+            }
+            for (int x = 0; x < cols; ++x) {
+                int entering = x + kernelDim - pad, leaving = x - pad;
+                for (int c = 0; c < channels; ++c) {
+                    out[x * channels + c] = static_cast<uchar>(static_cast<float>(sums[c]) / kernelIntensity);
+                    if (entering < cols) sums[c] += column_sums[entering * channels + c];
+                    if (leaving >= 0) sums[c] -= column_sums[leaving * channels + c];
                 }
             }
+
+            int entering = y + kernelDim - pad, leaving = y - pad;
+            if (entering < rows) {
+                const uchar* row = image.ptr<uchar>(entering);
+                for (size_t i = 0; i < column_sums.size(); ++i) column_sums[i] += row[i];
+            }
+            if (leaving >= 0) {
+                const uchar* row = image.ptr<uchar>(leaving);
+                for (size_t i = 0; i < column_sums.size(); ++i) column_sums[i] -= row[i];
+            }
         }
         return output;
     }
 
+    namespace {
+        using SobelX = convolution::Kernel<3, -1, 0, 1, -2, 0, 2, -1, 0, 1>;
+        using SobelY = convolution::Kernel<3, -1, -2, -1, 0, 0, 0, 1, 2, 1>;
+        // The centre tap of the Laplace kernel is the caller's intensity, so laplaceFilter adds it itself.
+        using LaplaceNeighbours = convolution::Kernel<3, 0, -1, 0, -1, 0, -1, 0, -1, 0>;
+    }
+
     cv::Mat sobelFilter(const cv::Mat& image, const std::string& mode, int intensity) {
         CV_Assert(image.channels() == 1);
-        int sx[3][3] = {{-1, 0, 1}, {-2, 0, 2}, {-1, 0, 1}};
-        int sy[3][3] = {{-1, -2, -1}, {0, 0, 0}, {1, 2, 1}};
         cv::Mat output = cv::Mat::zeros(image.size(), CV_8UC1);
-        cv::Mat padded;
-        cv::copyMakeBorder(image, padded, 1, 1, 1, 1, cv::BORDER_CONSTANT);
-
-        for (int y = 0; y < image.rows; ++y) {
-            for (int x = 0; x < image.cols; ++x) {
-                int gx = 0, gy = 0;
-                for (int i = 0; i < 3; ++i)
-                    for (int j = 0; j < 3; ++j) {
-                        int val = padded.at<uchar>(y + i, x + j);
-                        gx += sx[i][j] * val * intensity;
-                        gy += sy[i][j] * val * intensity;
-                    }
-
-                if (mode == "vertical")
-                    output.at<uchar>(y, x) = std::clamp(abs(gx), 0, 255);
-                else if (mode == "horizontal")
-                    output.at<uchar>(y, x) = std::clamp(abs(gy), 0, 255);
-                else if (mode == "both")
-                    output.at<uchar>(y, x) = std::clamp((int)std::sqrt(gx * gx + gy * gy), 0, 255);
+        if (image.empty()) return output;
+
+        if (mode == "vertical" || mode == "horizontal") {
+            auto store_absolute = [&](int y, const int* gradient) {
+                uchar* out = output.ptr<uchar>(y);
+                for (int x = 0; x < image.cols; ++x) out[x] = static_cast<uchar>(std::min(std::abs(gradient[x] * intensity), 255));
+            };
+            if (mode == "vertical") {
+                convolution::convolve<SobelX>(image, cv::BORDER_CONSTANT, store_absolute);
+            } else {
+                convolution::convolve<SobelY>(image, cv::BORDER_CONSTANT, store_absolute);
             }
+        } else if (mode == "both") {
+            convolution::convolve<SobelX, SobelY>(image, cv::BORDER_CONSTANT, [&](int y, const int* gx, const int* gy) {
+                uchar* out = output.ptr<uchar>(y);
+                for (int x = 0; x < image.cols; ++x) {
+                    int sx = gx[x] * intensity, sy = gy[x] * intensity;
+                    out[x] = static_cast<uchar>(std::clamp(static_cast<int>(std::sqrt(sx * sx + sy * sy)), 0, 255));
+                }
+            });
         }
         return output;
     }
 
     cv::Mat laplaceFilter(const cv::Mat& image, int intensity, int threshold) {
         CV_Assert(image.channels() == 1);
-        int kernel[3][3] = {{0, -1, 0}, {-1, intensity, -1}, {0, -1, 0}};
-        cv::Mat padded;
-        cv::copyMakeBorder(image, padded, 1, 1, 1, 1, cv::BORDER_REPLICATE);
         cv::Mat output = cv::Mat::zeros(image.size(), CV_8UC1);
+        if (image.empty()) return output;
 
-        for (int y = 0; y < image.rows; ++y)
+        convolution::convolve<LaplaceNeighbours>(image, cv::BORDER_REPLICATE, [&](int y, const int* neighbours) {
+            const uchar* in = image.ptr<uchar>(y);
+            uchar* out = output.ptr<uchar>(y);
             for (int x = 0; x < image.cols; ++x) {
-                int sum = 0;
-                for (int i = 0; i < 3; ++i)
-                    for (int j = 0; j < 3; ++j)
-                        sum += kernel[i][j] * padded.at<uchar>(y + i, x + j);
-                sum = std::clamp(sum, 0, 255);
-                output.at<uchar>(y, x) = threshold ? (sum >= threshold ? 255 : 0) : sum;
+                int sum = std::clamp(neighbours[x] + intensity * in[x], 0, 255);
+                out[x] = static_cast<uchar>(threshold ? (sum >= threshold ? 255 : 0) : sum);
             }
+        });
         return output;
     }
 
@@ -133,53 +170,141 @@ namespace filters {
     }
 
     cv::Mat erosion(const cv::Mat& image, int dim) {
-        int pad = dim / 2;
-        cv::Mat padded, output(image.size(), image.type());
-        cv::copyMakeBorder(image, padded, pad, pad, pad, pad, cv::BORDER_REPLICATE);
-        for (int y = 0; y < image.rows; ++y)
-            for (int x = 0; x < image.cols; ++x)
-                for (int c = 0; c < image.channels(); ++c) {
-                    uchar minVal = 255;
-                    for (int i = 0; i < dim; ++i)
-                        for (int j = 0; j < dim; ++j)
-                            minVal = std::min(minVal, padded.at<cv::Vec3b>(y + i, x + j)[c]);
-                    output.at<cv::Vec3b>(y, x)[c] = minVal;
-                }
-        return output;
+        return morphology::erode(image, dim);
     }
 
     cv::Mat dilation(const cv::Mat& image, int dim) {
-        int pad = dim / 2;
-        cv::Mat padded, output(image.size(), image.type());
-        cv::copyMakeBorder(image, padded, pad, pad, pad, pad, cv::BORDER_REPLICATE);
-        for (int y = 0; y < image.rows; ++y)
-            for (int x = 0; x < image.cols; ++x)
-                for (int c = 0; c < image.channels(); ++c) {
-                    uchar maxVal = 0;
-                    for (int i = 0; i < dim; ++i)
-                        for (int j = 0; j < dim; ++j)
-                            maxVal = std::max(maxVal, padded.at<cv::Vec3b>(y + i, x + j)[c]);
-                    output.at<cv::Vec3b>(y, x)[c] = maxVal;
-                }
-        return output;
+        return morphology::dilate(image, dim);
     }
 
-    cv::Mat medianFilter(const cv::Mat& image, int dim) {
-        int pad = dim / 2;
-        cv::Mat padded, output(image.size(), image.type());
-        cv::copyMakeBorder(image, padded, pad, pad, pad, pad, cv::BORDER_REPLICATE);
+    namespace {
+        // Bin of a 16-bin histogram that holds element rank, given that `below` elements precede the histogram;
+        // below is advanced past the bins before it. Branch-free, since the median bin is unpredictable.
+        template <typename Count>
+        inline int find_bin(const Count* bins, Count rank, Count& below) {
+            Count running = below;
+            int bin = 0;
+            for (int b = 0; b < 16; ++b) {
+                running += bins[b];
+                bool before = running <= rank;
+                bin += before;
+                below = before ? running : below;
+            }
+            return bin;
+        }
 
-        for (int y = 0; y < image.rows; ++y)
-            for (int x = 0; x < image.cols; ++x)
-                for (int c = 0; c < image.channels(); ++c) {
-                    std::vector<uchar> neighborhood;
-                    for (int i = 0; i < dim; ++i)
-                        for (int j = 0; j < dim; ++j)
-                            neighborhood.push_back(padded.at<cv::Vec3b>(y + i, x + j)[c]);
-                    std::nth_element(neighborhood.begin(), neighborhood.begin() + neighborhood.size() / 2, neighborhood.end());
-                    output.at<cv::Vec3b>(y, x)[c] = neighborhood[neighborhood.size() / 2];
+        // Constant-time median after Perreault and Hebert. Every padded column keeps a 256-bin histogram of
+        // the dim pixels it contributes to the window, plus a 16-bin coarse one; both are slid down one row per
+        // output row. Along a row the coarse window histogram is slid by adding the entering column and
+        // subtracting the leaving one, which locates the 16-value segment holding the median. Only that segment
+        // of the fine window histogram is then brought up to date, from the column where it was last used.
+        //
+        // The window of output pixel (y, x) covers padded rows y ... y + dim - 1 and columns x ... x + dim - 1,
+        // and the result is element dim * dim / 2 of the sorted window, as nth_element picks it.
+        template <typename Count>
+        void running_median(const cv::Mat& padded, int dim, cv::Mat& output) {
+            const int rows = output.rows, cols = output.cols, channels = output.channels();
+            const size_t columns = static_cast<size_t>(cols + dim - 1) * channels;    // one per column and channel
+            const Count rank = static_cast<Count>(dim * dim / 2);
+
+            std::vector<Count>& histograms = scratch::vector<Count>(scratch::MEDIAN_HISTOGRAMS);
+            histograms.assign(columns * (256 + 16), 0);
+            Count* fine = histograms.data();
+            Count* coarse = fine + columns * 256;
+            auto column_fine = [&](int x, int c) { return fine + (static_cast<size_t>(x) * channels + c) * 256; };
+            auto column_coarse = [&](int x, int c) { return coarse + (static_cast<size_t>(x) * channels + c) * 16; };
+
+            for (int r = 0; r < dim; ++r) {
+                const uchar* row = padded.ptr<uchar>(r);
+                for (size_t h = 0; h < columns; ++h) {
+                    ++fine[h * 256 + row[h]];
+                    ++coarse[h * 16 + (row[h] >> 4)];
                 }
-        return output;
+            }
+
+            Count window_fine[256], window_coarse[16];
+            int segment_end[16];    // window_fine segment s holds columns segment_end[s] - dim ... segment_end[s] - 1
+            for (int y = 0; y < rows; ++y) {
+                uchar* out = output.ptr<uchar>(y);
+                for (int c = 0; c < channels; ++c) {
+                    std::fill(window_coarse, window_coarse + 16, 0);
+                    for (int x = 0; x < dim; ++x) {
+                        const Count* entering = column_coarse(x, c);
+                        for (int b = 0; b < 16; ++b) window_coarse[b] += entering[b];
+                    }
+                    std::fill(segment_end, segment_end + 16, 0);
+
+                    for (int x = 0; x < cols; ++x) {
+                        Count below = 0;
+                        int segment = find_bin(window_coarse, rank, below);
+
+                        Count* bins = window_fine + segment * 16;
+                        int& end = segment_end[segment];
+                        if (end <= x) {
+                            // Nothing of this segment overlaps the window any more: rebuild it.
+                            std::fill(bins, bins + 16, 0);
+                            for (end = x; end < x + dim; ++end) {
+                                const Count* entering = column_fine(end, c) + segment * 16;
+                                for (int b = 0; b < 16; ++b) bins[b] += entering[b];
+                            }
+                        } else {
+                            for (; end < x + dim; ++end) {
+                                const Count* entering = column_fine(end, c) + segment * 16;
+                                const Count* leaving = column_fine(end - dim, c) + segment * 16;
+                                for (int b = 0; b < 16; ++b) bins[b] += entering[b] - leaving[b];
+                            }
+                        }
+
+                        out[x * channels + c] = static_cast<uchar>(segment * 16 + find_bin(bins, rank, below));
+
+                        if (x + 1 == cols) break;
+                        const Count* entering = column_coarse(x + dim, c);
+                        const Count* leaving = column_coarse(x, c);
+                        for (int b = 0; b < 16; ++b) window_coarse[b] += entering[b] - leaving[b];
+                    }
+                }
+
+                if (y + 1 == rows) break;
+                const uchar* leaving = padded.ptr<uchar>(y);
+                const uchar* entering = padded.ptr<uchar>(y + dim);
+                for (size_t h = 0; h < columns; ++h) {
+                    --fine[h * 256 + leaving[h]];
+                    --coarse[h * 16 + (leaving[h] >> 4)];
+                    ++fine[h * 256 + entering[h]];
+                    ++coarse[h * 16 + (entering[h] >> 4)];
+                }
+            }
+        }
+
+        // Median of every dim x dim window of image, padded by pad with border_type; any 8-bit channel count.
+        cv::Mat median_filter(const cv::Mat& image, int dim, int pad, int border_type) {
+            CV_Assert(image.depth() == CV_8U && dim > 0 && 2 * pad >= dim - 1);
+            cv::Mat output(image.size(), image.type());
+            if (image.empty()) return output;
+            cv::Mat padded = padded_scratch(image, pad);
+            cv::copyMakeBorder(image, padded, pad, pad, pad, pad, border_type);
+            // 16-bit counts halve the histogram traffic and hold any window of up to 255 x 255 pixels.
+            // The image is filtered in vertical stripes narrow enough for their column histograms to stay in
+            // L2 cache; the histogram updates hit random bins and are far slower from main memory.
+            size_t count_size = dim <= 255 ? sizeof(uint16_t) : sizeof(uint32_t);
+            size_t column_bytes = static_cast<size_t>(image.channels()) * (256 + 16) * count_size;
+            int stripe = std::max(64, static_cast<int>((256u << 10) / column_bytes) - (dim - 1));
+            for (int x = 0; x < image.cols; x += stripe) {
+                int width = std::min(stripe, image.cols - x);
+                cv::Mat padded_stripe = padded(cv::Rect(x, 0, width + dim - 1, padded.rows));
+                cv::Mat output_stripe = output(cv::Rect(x, 0, width, image.rows));
+                if (dim <= 255) {
+                    running_median<uint16_t>(padded_stripe, dim, output_stripe);
+                } else {
+                    running_median<uint32_t>(padded_stripe, dim, output_stripe);
+                }
+            }
+            return output;
+        }
+    }
+
+    cv::Mat medianFilter(const cv::Mat& image, int dim) {
+        return median_filter(image, dim, dim / 2, cv::BORDER_REPLICATE);
     }
     cv::Mat centerKernel(const cv::Mat& kernel, cv::Size targetSize) {
         cv::Mat padded = cv::Mat::zeros(targetSize, CV_32F);
@@ -289,33 +414,8 @@ namespace filters {
 
     // Median Filter using Sorted Window
     cv::Mat medianFilterSorted(const cv::Mat& src, int dim) {
+        // The window spans pad pixels on each side of the centre, so an even dim acts as dim + 1.
         int pad = dim / 2;
-        cv::Mat padded;
-        copyMakeBorder(src, padded, pad, pad, pad, pad, cv::BORDER_REFLECT);
-
-        cv::Mat dst = cv::Mat::zeros(src.size(), src.type());
-
-        if (src.channels() == 1) {
-            for (int y = 0; y < src.rows; ++y) {
-                for (int x = 0; x < src.cols; ++x) {
-                    vector<uchar> window;
-                    for (int dy = -pad; dy <= pad; ++dy) {
-                        for (int dx = -pad; dx <= pad; ++dx) {
-                            window.push_back(padded.at<uchar>(y + pad + dy, x + pad + dx));
-                        }
-                    }
-                    nth_element(window.begin(), window.begin() + window.size()/2, window.end());
-                    dst.at<uchar>(y, x) = window[window.size()/2];
-                }
-            }
-        } else {
-            vector<cv::Mat> channels;
-            split(src, channels);
-            for (int c = 0; c < src.channels(); ++c)
-                channels[c] = medianFilterSorted(channels[c], dim);
-            merge(channels, dst);
-        }
-
-    return dst;
+        return median_filter(src, 2 * pad + 1, pad, cv::BORDER_REFLECT);
     }
 }
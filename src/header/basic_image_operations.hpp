@@ -2,6 +2,7 @@
 #define BASIC_IMAGE_OPERATIONS_HPP
 
 #include <opencv2/opencv.hpp>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -12,6 +13,20 @@ namespace basic_ops {
 
     cv::Mat load_image(const std::string& image_path, bool print=true);
 
+    // Decodes the contents of the file at image_path exactly as load_image reads the file (no EXIF rotation,
+    // channels as stored); image_path only selects the format-specific handling.
+    cv::Mat decode_image(const std::vector<uint8_t>& bytes, const std::string& image_path);
+
+    // Loads a 3-channel image at roughly 1/scale_factor of its size. JPEGs are decoded directly at 1/2, 1/4
+    // or 1/8 resolution (libjpeg DCT scaling), which never materializes the full frame; any remaining factor
+    // and other formats go through a full decode followed by geo_ops::resize_image. Reduced JPEG decoding
+    // rounds odd sizes up, so the result can be one pixel larger than width / scale_factor.
+    cv::Mat load_image_scaled(const std::string& image_path, int scale_factor, bool print=true);
+
+    // The first amount image files of folder_path in sorted path order.
+    std::vector<std::string> list_image_paths(const std::string& folder_path, int amount);
+
+    // Decodes in parallel (see ImageLoader); the images keep the order of list_image_paths.
     std::vector<cv::Mat> load_images(const std::string& folder_path, int amount, bool print=true);
 
     void save_image(const cv::Mat& image, const std::string& save_path, bool print=true);
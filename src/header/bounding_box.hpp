@@ -4,6 +4,8 @@
 #include <vector>
 #include <array>
 #include <optional>
+#include <sstream>
+#include <string>
 #include <opencv2/opencv.hpp>
 
 class BoundingBox {
@@ -42,18 +44,28 @@ public:
 };
 
 namespace bounding_box {
-    BoundingBox create_bounding_box(const std::vector<cv::Point>& blob, int image_index,
-                                                   int min_box_area, int max_box_area, cv::Vec3b& box_color);
+    // Empty if the blob's box is outside [min_box_area, max_box_area] or too elongated for a sign.
+    std::optional<BoundingBox> create_bounding_box(const std::vector<cv::Point>& blob, int image_index,
+                                                   int min_box_area, int max_box_area, const cv::Vec3b& box_color);
 
     std::vector<BoundingBox> create_bounding_boxes(const std::vector<std::vector<cv::Point>>& blobs, int image_index,
-                                                   int min_box_area, int max_box_area, cv::Vec3b& box_color);
+                                                   int min_box_area, int max_box_area, const cv::Vec3b& box_color);
 
     cv::Mat draw_bounding_box(const BoundingBox& bounding_box, cv::Mat& image);
+    // Copy-on-write annotation: image itself is never modified. With nothing to draw the result shares image's
+    // pixels (treat it as read-only); otherwise the boxes are drawn onto a fresh copy.
+    cv::Mat draw_bounding_boxes(const cv::Mat& image, const std::vector<BoundingBox>& bounding_boxes);
 
     std::vector<BoundingBox> fuse_bounding_box_matches(const std::vector<BoundingBox>& boxes1,
                                                        const std::vector<BoundingBox>& boxes2, int max_deviation);
 
     std::vector<BoundingBox> merge_duplicate_boxes(const std::vector<BoundingBox>& boxes, int max_deviation);
+
+    // Replaces overlapping regions by their bounding rectangle until no two regions overlap.
+    std::vector<cv::Rect> merge_overlapping_regions(std::vector<cv::Rect> regions);
+
+    // Each box grown by padding * its size on every side, clipped to image_size, with overlaps merged.
+    std::vector<cv::Rect> padded_box_regions(const std::vector<BoundingBox>& boxes, const cv::Size& image_size, float padding);
 }
 
 #endif // BOUNDING_BOX_HPP
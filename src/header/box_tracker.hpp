@@ -0,0 +1,43 @@
+#ifndef BOX_TRACKER_HPP
+#define BOX_TRACKER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "../header/bounding_box.hpp"
+
+// Carries bounding boxes from frame to frame of a sequence. Detections are matched greedily to the nearest
+// track center, each track keeps a smoothed constant-velocity estimate, and tracks that go unmatched for
+// more than max_misses frames are dropped. The predicted regions tell the next frame where to look.
+class BoxTracker {
+public:
+    struct Track {
+        int id;
+        BoundingBox box;
+        float velocity_x;
+        float velocity_y;
+        int hits;
+        int misses;
+    };
+
+    // A detection matches a track if their centers are closer than match_gate * the track's larger side.
+    explicit BoxTracker(int max_misses = 2, float match_gate = 1.0f, float velocity_smoothing = 0.5f);
+
+    void update(const std::vector<BoundingBox>& detections);
+    void clear();
+
+    // Regions around each track's predicted position, grown by padding * box size on every side, clipped to
+    // image_size and with overlapping regions merged so no pixel is processed twice.
+    std::vector<cv::Rect> predicted_regions(const cv::Size& image_size, float padding) const;
+
+    const std::vector<Track>& tracks() const { return active_tracks; }
+    bool empty() const { return active_tracks.empty(); }
+
+private:
+    int max_misses;
+    float match_gate;
+    float velocity_smoothing;
+    int next_id = 0;
+    std::vector<Track> active_tracks;
+};
+
+#endif // BOX_TRACKER_HPP
@@ -9,6 +9,9 @@ using Coord = std::pair<int, int>;
 using Blob = std::vector<Coord>;
 namespace cd {
     std::vector<std::vector<cv::Point>> get_blobs(cv::Mat mask);
+    // Fills blobs with the 4-connected blobs of a binary mask. The label image and fill stack are per-thread
+    // scratch and the inner vectors keep their capacity, so repeated calls do not allocate in steady state.
+    void get_blobs(const cv::Mat& mask, std::vector<std::vector<cv::Point>>& blobs);
 
 #endif // COLOR_DETECTION_HPP
 }
@@ -2,18 +2,139 @@
 #define COLORS_HPP
 
 #include <opencv2/opencv.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <string>
+#include <vector>
+#include "../header/profiling.hpp"
 
 namespace colors {
+    // Planar 8-bit HSV in OpenCV's convention: h in [0, 180), s and v in [0, 255].
+    struct HsvPlanes {
+        cv::Mat h;
+        cv::Mat s;
+        cv::Mat v;
+    };
+
     cv::Vec3f bgr_to_hsv(const cv::Vec3b& bgr);
 
-    bool is_strong_red(float h, float s, float v);
-    bool is_strong_green(float h, float s, float v);
-    bool is_strong_blue(float h, float s, float v);
-    bool is_strong_yellow(float h, float s, float v);
+    // Converts a whole CV_8UC3 image at once, bit-exact with cv::cvtColor(COLOR_BGR2HSV).
+    // Uses an AVX2 kernel when the CPU supports it.
+    HsvPlanes bgr_to_hsv_planes(const cv::Mat& image);
+
+    inline bool is_strong_red(float h, float s, float v) {
+        bool is_hue_red = (h >= 340.0f || h <= 20.0f);
+        bool is_saturated = (s >= 0.3f);
+        bool is_bright_enough = (v >= 0.1f);
+        return is_hue_red && is_saturated && is_bright_enough;
+    }
+
+    inline bool is_strong_green(float h, float s, float v) {
+        bool is_hue_green = (h >= 105.0f && h <= 135.0f);
+        bool is_saturated = (s >= 0.3f);
+        bool is_bright_enough = (v >= 0.1f);
+        return is_hue_green && is_saturated && is_bright_enough;
+    }
+
+    inline bool is_strong_blue(float h, float s, float v) {
+        bool is_hue_blue = (h >= 200.0f && h <= 240.0f);
+        bool is_saturated = (s >= 0.4f);
+        bool is_bright_enough = (v >= 0.2f);
+        return is_hue_blue && is_saturated && is_bright_enough;
+    }
+
+    inline bool is_strong_yellow(float h, float s, float v) {
+        bool is_hue_yellow = (h >= 35.0f && h <= 65.0f);
+        bool is_saturated = (s >= 0.5f);
+        bool is_bright_enough = (v >= 0.3f);
+        return is_hue_yellow && is_saturated && is_bright_enough;
+    }
+
+    // Color classes pair a predicate with the box color drawn for its detections and their bit in the color LUT.
+    // They are passed as template arguments so the predicates are resolved at compile time.
+    struct StrongRed {
+        static constexpr uint8_t lut_bit = 1 << 0;
+        static bool matches(float h, float s, float v) { return is_strong_red(h, s, v); }
+        static cv::Vec3b box_color() { return {0, 0, 255}; }
+    };
+
+    struct StrongGreen {
+        static constexpr uint8_t lut_bit = 1 << 1;
+        static bool matches(float h, float s, float v) { return is_strong_green(h, s, v); }
+        static cv::Vec3b box_color() { return {0, 255, 0}; }
+    };
+
+    struct StrongBlue {
+        static constexpr uint8_t lut_bit = 1 << 2;
+        static bool matches(float h, float s, float v) { return is_strong_blue(h, s, v); }
+        static cv::Vec3b box_color() { return {255, 0, 0}; }
+    };
+
+    struct StrongYellow {
+        static constexpr uint8_t lut_bit = 1 << 3;
+        static bool matches(float h, float s, float v) { return is_strong_yellow(h, s, v); }
+        static cv::Vec3b box_color() { return {0, 255, 255}; }
+    };
 
     cv::Mat get_mask(const cv::Mat& image, std::function<bool(float, float, float)> color_function);
-    cv::Vec3b get_color_from_function(const std::function<bool(float, float, float)>& color_function);
+    cv::Mat get_mask(const HsvPlanes& hsv, const std::function<bool(float, float, float)>& color_function);
+
+    // Bitmask of the matching color classes for every 8-bit BGR value, indexed by (b << 16) | (g << 8) | r.
+    // Built on first use unless load_color_lut() was called before.
+    const std::vector<uint8_t>& get_color_lut();
+    bool load_color_lut(const std::string& path);
+    bool save_color_lut(const std::string& path);
+
+    inline uint8_t get_color_label(const cv::Vec3b& bgr, const uint8_t* lut) {
+        return lut[(bgr[0] << 16) | (bgr[1] << 8) | bgr[2]];
+    }
+
+    // Classifies every pixel into all given color classes in one pass over the image.
+    // masks[i] is 255 where ColorClasses[i] matches, 0 elsewhere. Masks that already have the image size
+    // and type CV_8U are overwritten in place, so scratch buffers can be passed in.
+    template <typename... ColorClasses>
+    void get_masks(const cv::Mat& image, std::array<cv::Mat, sizeof...(ColorClasses)>& masks) {
+        CV_Assert(image.type() == CV_8UC3);
+        PROFILE_SCOPE("get_masks");
+
+        const uint8_t* lut = get_color_lut().data();
+        for (auto& mask : masks) {
+            mask.create(image.rows, image.cols, CV_8U);
+        }
+
+        for (int y = 0; y < image.rows; ++y) {
+            const cv::Vec3b* row_ptr = image.ptr<cv::Vec3b>(y);
+            std::array<uchar*, sizeof...(ColorClasses)> mask_ptrs;
+            for (size_t c = 0; c < masks.size(); ++c) {
+                cv::Mat& mask = masks[c];
+                mask_ptrs[c] = mask.ptr<uchar>(y);
+            }
+
+            for (int x = 0; x < image.cols; ++x) {
+                uint8_t label = get_color_label(row_ptr[x], lut);
+                size_t c = 0;
+                ((mask_ptrs[c++][x] = (label & ColorClasses::lut_bit) ? 255 : 0), ...);
+            }
+        }
+    }
+
+    template <typename... ColorClasses>
+    std::array<cv::Mat, sizeof...(ColorClasses)> get_masks(const cv::Mat& image) {
+        std::array<cv::Mat, sizeof...(ColorClasses)> masks;
+        get_masks<ColorClasses...>(image, masks);
+        return masks;
+    }
+
+    template <typename ColorClass>
+    cv::Mat get_mask(const cv::Mat& image) {
+        return get_masks<ColorClass>(image)[0];
+    }
+
+    template <typename... ColorClasses>
+    std::array<cv::Vec3b, sizeof...(ColorClasses)> get_box_colors() {
+        return {ColorClasses::box_color()...};
+    }
 }
 #endif // COLORS_HPP
-
@@ -0,0 +1,28 @@
+#ifndef CONST_SPAN_HPP
+#define CONST_SPAN_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Read-only view of contiguous elements owned by someone else (std::span<const T> is C++20). Stages take
+// their input batches as ConstSpan so they can neither copy nor modify them; the owner must outlive the call.
+template <typename T>
+class ConstSpan {
+public:
+    ConstSpan() = default;
+    ConstSpan(const T* data, size_t size) : elements(data), count(size) {}
+    ConstSpan(const std::vector<T>& elements) : elements(elements.data()), count(elements.size()) {}
+
+    const T* begin() const { return elements; }
+    const T* end() const { return elements + count; }
+    const T& operator[](size_t i) const { return elements[i]; }
+    const T* data() const { return elements; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    const T* elements = nullptr;
+    size_t count = 0;
+};
+
+#endif // CONST_SPAN_HPP
@@ -0,0 +1,138 @@
+#ifndef CONVOLUTION_HPP
+#define CONVOLUTION_HPP
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "scratch_buffers.hpp"
+
+// Integer convolution of 8-bit single-channel images with kernels whose coefficients are template arguments.
+// Every tap is a compile-time constant, so zero taps vanish and the per-row loops run over plain row pointers
+// with nothing but multiply-adds inside, which the compiler unrolls and vectorizes. Kernels that factor into
+// a column times a row vector are detected at compile time and applied as two 1-D passes.
+//
+//     using SobelX = convolution::Kernel<3, -1, 0, 1, -2, 0, 2, -1, 0, 1>;
+//     convolution::convolve<SobelX>(gray, cv::BORDER_CONSTANT, [&](int y, const int* responses) { ... });
+namespace convolution {
+
+    namespace detail {
+        // Integer rank-1 factorization coefficients[i][j] == column[i] * row[j], if the kernel has one.
+        template <int Size>
+        struct Factors {
+            bool separable = false;
+            std::array<int, Size> column{};
+            std::array<int, Size> row{};
+        };
+
+        template <int Size>
+        constexpr Factors<Size> factorize(const std::array<int, Size * Size>& coefficients) {
+            Factors<Size> factors;
+            int pivot = 0;
+            while (pivot < Size * Size && coefficients[pivot] == 0) ++pivot;
+            if (pivot == Size * Size) return factors;
+
+            int pivot_row = pivot / Size, pivot_col = pivot % Size;
+            for (int j = 0; j < Size; ++j) factors.row[j] = coefficients[pivot_row * Size + j];
+            for (int i = 0; i < Size; ++i) {
+                int value = coefficients[i * Size + pivot_col];
+                if (value % coefficients[pivot] != 0) return factors;
+                factors.column[i] = value / coefficients[pivot];
+            }
+            for (int i = 0; i < Size; ++i)
+                for (int j = 0; j < Size; ++j)
+                    if (factors.column[i] * factors.row[j] != coefficients[i * Size + j]) return factors;
+            factors.separable = true;
+            return factors;
+        }
+    }
+
+    // Square kernel of odd Size; Coefficients are listed row by row.
+    template <int Size, int... Coefficients>
+    struct Kernel {
+        static_assert(Size % 2 == 1, "Kernel size must be odd");
+        static_assert(sizeof...(Coefficients) == Size * Size, "Kernel needs Size * Size coefficients");
+
+        static constexpr int size = Size;
+        static constexpr int radius = Size / 2;
+        static constexpr std::array<int, Size * Size> coefficients = {Coefficients...};
+        static constexpr detail::Factors<Size> factors = detail::factorize<Size>(coefficients);
+        static constexpr bool separable = factors.separable;
+    };
+
+    namespace detail {
+        template <typename First, typename... Rest>
+        struct FirstOf { using type = First; };
+
+        template <typename K, size_t... I>
+        inline int column_sum(const uchar* const* window, int x, std::index_sequence<I...>) {
+            return (0 + ... + (K::factors.column[I] == 0 ? 0 : K::factors.column[I] * window[I][x]));
+        }
+
+        template <typename K, size_t... I>
+        inline int row_sum(const int* values, std::index_sequence<I...>) {
+            return (0 + ... + (K::factors.row[I] == 0 ? 0 : K::factors.row[I] * values[I]));
+        }
+
+        template <typename K, size_t... I>
+        inline int window_sum(const uchar* const* window, int x, std::index_sequence<I...>) {
+            return (0 + ... + (K::coefficients[I] == 0 ? 0 : K::coefficients[I] * window[I / K::size][x + I % K::size]));
+        }
+
+        // window holds the K::size padded input rows of one output row; vertical has room for a padded row.
+        template <typename K>
+        void convolve_row(const uchar* const* window, int cols, int* vertical, int* responses) {
+            if constexpr (K::separable) {
+                constexpr auto taps = std::make_index_sequence<K::size>();
+                for (int x = 0; x < cols + 2 * K::radius; ++x) vertical[x] = column_sum<K>(window, x, taps);
+                for (int x = 0; x < cols; ++x) responses[x] = row_sum<K>(vertical + x, taps);
+            } else {
+                constexpr auto taps = std::make_index_sequence<K::size * K::size>();
+                for (int x = 0; x < cols; ++x) responses[x] = window_sum<K>(window, x, taps);
+            }
+        }
+
+        template <typename Sink, size_t... I>
+        inline void emit_row(Sink& sink, int y, const int* responses, int cols, std::index_sequence<I...>) {
+            sink(y, (responses + I * cols)...);
+        }
+    }
+
+    // Applies every kernel of Kernels to padded, an 8-bit single-channel image already padded by the kernel
+    // radius on every side (as copyMakeBorder does). For each output row y, sink(y, responses...) is called with
+    // one const int* per kernel, holding the responses of that row; the sink scales, clamps and stores them.
+    template <typename... Kernels, typename Sink>
+    void convolve_padded(const cv::Mat& padded, Sink&& sink) {
+        using First = typename detail::FirstOf<Kernels...>::type;
+        static_assert(((Kernels::size == First::size) && ...), "Kernels applied together must have the same size");
+        constexpr int radius = First::radius;
+        constexpr size_t count = sizeof...(Kernels);
+        CV_Assert(padded.type() == CV_8UC1 && padded.rows >= 2 * radius && padded.cols >= 2 * radius);
+
+        int rows = padded.rows - 2 * radius, cols = padded.cols - 2 * radius;
+        std::vector<int>& buffer = scratch::vector<int>(scratch::CONVOLUTION_ROWS);
+        buffer.resize(count * cols + padded.cols);
+        int* responses = buffer.data();
+        int* vertical = responses + count * cols;
+
+        const uchar* window[First::size];
+        for (int y = 0; y < rows; ++y) {
+            for (int i = 0; i < First::size; ++i) window[i] = padded.ptr<uchar>(y + i);
+            size_t k = 0;
+            (detail::convolve_row<Kernels>(window, cols, vertical, responses + cols * k++), ...);
+            detail::emit_row(sink, y, responses, cols, std::make_index_sequence<count>());
+        }
+    }
+
+    // Pads image with border_type (BORDER_CONSTANT pads with 0) into scratch memory and runs convolve_padded.
+    template <typename... Kernels, typename Sink>
+    void convolve(const cv::Mat& image, int border_type, Sink&& sink) {
+        constexpr int radius = detail::FirstOf<Kernels...>::type::radius;
+        cv::Mat padded = scratch::mat(scratch::FILTER_PADDED, image.rows + 2 * radius, image.cols + 2 * radius, image.type());
+        cv::copyMakeBorder(image, padded, radius, radius, radius, radius, border_type);
+        convolve_padded<Kernels...>(padded, sink);
+    }
+}
+
+#endif // CONVOLUTION_HPP
@@ -0,0 +1,104 @@
+#ifndef DETECTION_SERVER_HPP
+#define DETECTION_SERVER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../header/bounded_queue.hpp"
+#include "../header/bounding_box.hpp"
+#include "../header/detector.hpp"
+
+// Long-running detection service on a Unix domain socket. The detector stays warm between requests, and
+// requests that arrive close together (from one or many connections) are coalesced into one detect_batch
+// call, so the parallel stages see full batches.
+//
+// Protocol (host byte order), any number of requests per connection, answered in order per connection:
+//   request:  RequestHeader, then payload_size bytes. With width == 0 the payload is an encoded image
+//             (JPEG, PNG, ...); otherwise it is width * height * 3 bytes of packed BGR pixels.
+//   response: ResponseHeader, then box_count result_stream::BoxRecord records (source_id = request_id).
+namespace detection_server {
+
+    enum Status : int32_t { OK = 0, BAD_IMAGE = 1, DETECTION_FAILED = 2 };
+
+    struct RequestHeader {
+        char magic[4];              // "TSRQ"
+        uint32_t request_id;
+        int32_t width;
+        int32_t height;
+        uint32_t payload_size;
+        uint8_t reserved[12];
+    };
+
+    struct ResponseHeader {
+        char magic[4];              // "TSRS"
+        uint32_t request_id;
+        int32_t status;
+        uint32_t box_count;
+    };
+
+    static_assert(sizeof(RequestHeader) == 32, "RequestHeader must stay 32 bytes");
+    static_assert(sizeof(ResponseHeader) == 16, "ResponseHeader must stay 16 bytes");
+
+    struct ServerOptions {
+        std::string socket_path;
+        size_t max_batch_size = 16;
+        int max_batch_latency_ms = 5;       // how long the first request of a batch waits for company
+        size_t max_pending = 256;           // decoded requests waiting for detection; readers block beyond
+        size_t max_payload_bytes = 64 << 20;
+    };
+
+    class Server {
+    public:
+        Server(const Detector& detector, ServerOptions options);
+        ~Server();
+
+        Server(const Server&) = delete;
+        Server& operator=(const Server&) = delete;
+
+        // Listens and serves until stop() is called. Throws std::runtime_error if the socket cannot be bound.
+        void run();
+
+        // Only sets a flag, so it is safe to call from a signal handler; run() notices within 200 ms.
+        void stop() { stopping.store(true); }
+
+        uint64_t requests_served() const { return served_count.load(); }
+        uint64_t batches_run() const { return batch_count.load(); }
+
+    private:
+        struct Connection;
+
+        struct PendingRequest {
+            std::shared_ptr<Connection> connection;
+            uint32_t request_id;
+            Status status;
+            cv::Mat image;
+            std::chrono::steady_clock::time_point received;
+        };
+
+        void read_loop(std::shared_ptr<Connection> connection);
+        void batch_loop();
+        void respond(const PendingRequest& request, const std::vector<BoundingBox>& bounding_boxes);
+
+        const Detector& detector;
+        ServerOptions options;
+        BoundedQueue<PendingRequest> pending;
+        std::atomic<bool> stopping{false};
+        std::atomic<uint64_t> served_count{0};
+        std::atomic<uint64_t> batch_count{0};
+
+        std::mutex connections_mutex;
+        std::vector<std::shared_ptr<Connection>> connections;
+    };
+
+    // Client side, used by the load generator. connect_to returns a socket descriptor or -1.
+    int connect_to(const std::string& socket_path);
+    bool send_request(int fd, uint32_t request_id, const std::vector<uint8_t>& encoded_image);
+    bool send_request(int fd, uint32_t request_id, const cv::Mat& bgr_image);
+    bool read_response(int fd, ResponseHeader& header, std::vector<BoundingBox>& bounding_boxes);
+}
+
+#endif // DETECTION_SERVER_HPP
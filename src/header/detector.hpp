@@ -0,0 +1,64 @@
+#ifndef DETECTOR_HPP
+#define DETECTOR_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../header/bounding_box.hpp"
+#include "../header/pipeline_config.hpp"
+#include "../header/pipeline_graph.hpp"
+#include "../header/result_cache.hpp"
+#include "../header/thread_pool.hpp"
+
+// Embeddable traffic sign detector. The pipeline graph and the worker threads are set up once in the
+// constructor; afterwards every detect call is const and may be made from several threads at once.
+// Images in a batch are processed in parallel and the i-th result belongs to the i-th image.
+class Detector {
+public:
+    // Interleaved 8-bit BGR pixels owned by the caller; stride is in bytes, 0 means tightly packed.
+    struct ImageBuffer {
+        const uint8_t* data;
+        int width;
+        int height;
+        size_t stride = 0;
+    };
+
+    // num_threads == 0 uses one worker per hardware thread.
+    explicit Detector(const pipeline_config::PipelineConfig& config = pipeline_config::default_config(),
+                      size_t num_threads = 0);
+    // Loads the config file once; throws std::runtime_error if it is malformed.
+    explicit Detector(const std::string& config_path, size_t num_threads = 0);
+
+    Detector(const Detector&) = delete;
+    Detector& operator=(const Detector&) = delete;
+
+    std::vector<BoundingBox> detect(const cv::Mat& image, int image_index = 0) const;
+    std::vector<BoundingBox> detect(const ImageBuffer& buffer, int image_index = 0) const;
+
+    // Box image_index values are first_image_index + position in the batch.
+    std::vector<std::vector<BoundingBox>> detect_batch(const std::vector<cv::Mat>& images, int first_image_index = 0) const;
+    std::vector<std::vector<BoundingBox>> detect_batch(const std::vector<ImageBuffer>& buffers, int first_image_index = 0) const;
+
+    // Like detect_batch, but also returns the annotation image of the config. Empty images give empty results.
+    std::vector<pipeline_graph::GraphResult> run_batch(const std::vector<cv::Mat>& images, int first_image_index = 0) const;
+    // Decodes the files on the worker threads as well; unreadable files give empty results.
+    // With a cache, files whose bytes were already processed under the same config are neither decoded nor
+    // detected; their results carry no annotation image. Misses are stored with the boxes of every stage.
+    std::vector<pipeline_graph::GraphResult> run_files(const std::vector<std::string>& image_paths, int first_image_index = 0,
+                                                       ResultCache* cache = nullptr) const;
+
+    size_t num_threads() const { return pool->size(); }
+
+    // Wraps a caller-owned buffer without copying.
+    static cv::Mat wrap_buffer(const ImageBuffer& buffer);
+
+private:
+    std::unique_ptr<ThreadPool> pool;       // declared first: the graph runs its branches on it
+    pipeline_graph::PipelineGraph graph;
+    uint64_t config_hash;
+};
+
+#endif // DETECTOR_HPP
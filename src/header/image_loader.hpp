@@ -0,0 +1,63 @@
+#ifndef IMAGE_LOADER_HPP
+#define IMAGE_LOADER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Decodes a list of image files on a set of background threads and hands the results out in list order,
+// so the consumer can work on one frame while the following files are still being decoded. At most
+// prefetch images are decoded ahead of the consumer, which bounds memory no matter how long the list is.
+class ImageLoader {
+public:
+    using DecodeFunction = std::function<cv::Mat(const std::string&)>;
+
+    struct LoadedImage {
+        size_t source_index;        // position in image_paths
+        std::string source_path;
+        cv::Mat image;
+    };
+
+    // num_threads == 0 uses one thread per hardware thread. Without a decode function the files are loaded
+    // with basic_ops::load_image.
+    explicit ImageLoader(std::vector<std::string> image_paths, size_t num_threads = 0, size_t prefetch = 8,
+                         DecodeFunction decode = {});
+    ~ImageLoader();
+
+    ImageLoader(const ImageLoader&) = delete;
+    ImageLoader& operator=(const ImageLoader&) = delete;
+
+    // Blocks until the next image in list order is decoded. Files that fail to decode are skipped.
+    // Returns std::nullopt once every file has been handed out or after close().
+    std::optional<LoadedImage> next();
+
+    // Stops the decode threads; images already decoded but not yet taken are dropped.
+    void close();
+
+    size_t size() const { return image_paths.size(); }
+
+private:
+    void decode_loop();
+
+    std::vector<std::string> image_paths;
+    size_t prefetch;
+    DecodeFunction decode;
+
+    std::mutex mutex;
+    std::condition_variable image_ready;
+    std::condition_variable slot_free;
+    std::map<size_t, cv::Mat> decoded;  // finished images not yet handed out, by source index
+    size_t next_to_decode = 0;
+    size_t next_to_deliver = 0;
+    bool closed = false;
+    std::vector<std::thread> threads;
+};
+
+#endif // IMAGE_LOADER_HPP
@@ -0,0 +1,49 @@
+#ifndef IMAGE_WRITER_HPP
+#define IMAGE_WRITER_HPP
+
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../header/bounded_queue.hpp"
+#include "../header/bounding_box.hpp"
+
+// Draws bounding boxes onto frames and encodes them to output_dir on a background thread,
+// so detection never waits on disk. If max_pending frames are already queued, new frames are
+// dropped and counted instead of blocking the caller, unless wait_when_full is set.
+class AnnotatedImageWriter {
+public:
+    AnnotatedImageWriter(const std::string& output_dir, size_t max_pending = 64);
+    ~AnnotatedImageWriter();
+
+    AnnotatedImageWriter(const AnnotatedImageWriter&) = delete;
+    AnnotatedImageWriter& operator=(const AnnotatedImageWriter&) = delete;
+
+    // The image is copied, so the caller may keep modifying it; boxes are drawn on the writer thread.
+    bool enqueue(const cv::Mat& image, std::vector<BoundingBox> bounding_boxes, const std::string& file_name,
+                 bool wait_when_full = false);
+
+    // Writes everything still queued, then stops the writer thread.
+    void close();
+
+    size_t written() const { return written_count.load(); }
+    size_t dropped() const { return dropped_count.load(); }
+
+private:
+    struct PendingImage {
+        cv::Mat image;
+        std::vector<BoundingBox> bounding_boxes;
+        std::string file_name;
+    };
+
+    void write_loop();
+
+    std::string output_dir;
+    BoundedQueue<PendingImage> pending;
+    std::atomic<size_t> written_count{0};
+    std::atomic<size_t> dropped_count{0};
+    std::thread writer;
+};
+
+#endif // IMAGE_WRITER_HPP
@@ -0,0 +1,34 @@
+#ifndef MORPHOLOGY_HPP
+#define MORPHOLOGY_HPP
+
+#include <opencv2/opencv.hpp>
+
+// Grayscale morphology with a dim x dim square structuring element on 8-bit images of any channel count,
+// channels treated independently. The window of pixel (y, x) spans rows and columns y - dim / 2 ... and
+// x - dim / 2 ..., dim of each, and the image border is replicated (cv::BORDER_REPLICATE).
+//
+// erode and dilate run the van Herk / Gil-Werman algorithm separably along rows and then columns, so each
+// output pixel costs about three comparisons per pass whatever dim is. The compound operators are built
+// from them; on binary masks opening removes specks smaller than the element and closing fills small holes.
+namespace morphology {
+
+    // Minimum over the window.
+    cv::Mat erode(const cv::Mat& image, int dim);
+
+    // Maximum over the window.
+    cv::Mat dilate(const cv::Mat& image, int dim);
+
+    // dilate(erode(image)).
+    cv::Mat opening(const cv::Mat& image, int dim);
+
+    // erode(dilate(image)).
+    cv::Mat closing(const cv::Mat& image, int dim);
+
+    // dilate(image) - erode(image): outlines on masks, edge strength on grayscale images.
+    cv::Mat gradient(const cv::Mat& image, int dim);
+
+    // image - opening(image): bright details smaller than the structuring element.
+    cv::Mat top_hat(const cv::Mat& image, int dim);
+}
+
+#endif // MORPHOLOGY_HPP
@@ -0,0 +1,97 @@
+#ifndef PACKED_DATASET_HPP
+#define PACKED_DATASET_HPP
+
+#include <opencv2/opencv.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Preprocessed frames stored as raw pixel blocks in one file, so a run can start without decoding anything.
+// The reader memory-maps the file and hands out cv::Mat headers that point straight into the mapping.
+//
+// File layout (host byte order):
+//   FileHeader
+//   pixel blocks, each continuous (step == cols * elemSize) and starting on a block_alignment boundary
+//   image_count IndexEntry records at FileHeader::index_offset, followed by the UTF-8 source paths
+// Every image stores the frame kinds of FileHeader::frame_kinds; FrameRecord::offset is 0 for the others.
+namespace packed_dataset {
+
+    enum FrameKind : uint32_t { RESIZED = 0, COLOR = 1, SHAPE = 2, FRAME_KIND_COUNT = 3 };
+
+    constexpr uint32_t frame_bit(FrameKind kind) { return 1u << kind; }
+
+    constexpr uint32_t format_version = 1;
+    constexpr size_t block_alignment = 64;
+
+    struct FileHeader {
+        char magic[4];              // "TSPK"
+        uint32_t version;
+        uint32_t image_count;
+        uint32_t frame_kinds;       // frame_bit() mask
+        uint64_t index_offset;
+        int32_t resize_factor;
+        uint8_t reserved[4];
+    };
+
+    struct FrameRecord {
+        uint64_t offset;
+        int32_t rows;
+        int32_t cols;
+        int32_t type;               // OpenCV type, e.g. CV_8UC3
+        uint8_t reserved[4];
+    };
+
+    struct IndexEntry {
+        uint64_t path_offset;
+        uint32_t path_length;
+        uint8_t reserved[4];
+        FrameRecord frames[FRAME_KIND_COUNT];
+    };
+
+    static_assert(sizeof(FileHeader) == 32, "FileHeader must stay 32 bytes");
+    static_assert(sizeof(FrameRecord) == 24, "FrameRecord must stay 24 bytes");
+    static_assert(sizeof(IndexEntry) == 88, "IndexEntry must stay 88 bytes");
+
+    struct PackOptions {
+        uint32_t frame_kinds = frame_bit(RESIZED) | frame_bit(COLOR);
+        int resize_factor = 8;      // the detection pipeline only reads packs with its RESIZE_FACTOR
+        size_t num_threads = 0;     // decode threads, 0 = one per hardware thread
+    };
+
+    // Decodes and preprocesses image_paths (as start_preprocessing_pipeline does) and writes them to
+    // output_path. Files that cannot be decoded are left out. Returns the number of images written;
+    // throws std::runtime_error if output_path cannot be written.
+    size_t pack_images(const std::vector<std::string>& image_paths, const std::string& output_path,
+                       const PackOptions& options = PackOptions());
+
+    // Read-only view of a packed file. The Mats returned by frame() share the mapping: they stay valid as
+    // long as the PackedDataset does, and are mapped copy-on-write, so writing to one never reaches the file.
+    class PackedDataset {
+    public:
+        // Throws std::runtime_error if the file cannot be mapped or is not a valid pack.
+        explicit PackedDataset(const std::string& path);
+        ~PackedDataset();
+
+        PackedDataset(const PackedDataset&) = delete;
+        PackedDataset& operator=(const PackedDataset&) = delete;
+
+        size_t size() const { return header->image_count; }
+        int resize_factor() const { return header->resize_factor; }
+        bool has_frames(FrameKind kind) const { return (header->frame_kinds & frame_bit(kind)) != 0; }
+
+        std::string source_path(size_t image_index) const;
+        // Empty if the pack does not store kind.
+        cv::Mat frame(size_t image_index, FrameKind kind) const;
+
+    private:
+        const IndexEntry& entry(size_t image_index) const;
+
+        uint8_t* data = nullptr;
+        size_t file_size = 0;
+        const FileHeader* header = nullptr;
+        const IndexEntry* index = nullptr;
+    };
+}
+
+#endif // PACKED_DATASET_HPP
@@ -2,9 +2,16 @@
 #define PIPELINE_BOX_FUSION_H
 
 #include "../header/bounding_box.hpp"
+#include "../header/const_span.hpp"
+#include "../header/image_writer.hpp"
 
 namespace box_fusion_pipeline {
-    std::vector<BoundingBox> start_pipeline_box_fusion(std::vector<BoundingBox> color_bounding_boxes, std::vector<BoundingBox> shape_bounding_boxes, std::vector<cv::Mat> resized_images);
+    std::vector<BoundingBox> fuse_boxes(const std::vector<BoundingBox>& color_bounding_boxes, const std::vector<BoundingBox>& shape_bounding_boxes,
+                                        int match_deviation = 15, int merge_deviation = 20);
+    // resized_images are only read; annotated frames are drawn onto copies (see bounding_box::draw_bounding_boxes).
+    std::vector<BoundingBox> start_pipeline_box_fusion(const std::vector<BoundingBox>& color_bounding_boxes, const std::vector<BoundingBox>& shape_bounding_boxes,
+                                                       ConstSpan<cv::Mat> resized_images, bool show_images = true,
+                                                       AnnotatedImageWriter* image_writer = nullptr);
 }
 
 #endif //PIPELINE_BOX_FUSION_H
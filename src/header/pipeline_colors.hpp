@@ -3,7 +3,17 @@
 #include <vector>
 #include <opencv2/opencv.hpp>
 #include "../header/bounding_box.hpp"
+#include "../header/const_span.hpp"
 
 namespace color_pipeline {
-    std::vector<BoundingBox> start_pipeline_colors(std::vector<cv::Mat> color_images);
+    // Boxes smaller than (min_box_ratio * image height)^2 are discarded. A mask_opening above 1 opens every
+    // color mask with that square size (morphology::opening) before blobs are extracted, dropping specks.
+    std::vector<BoundingBox> detect_color_boxes(const cv::Mat& color_image, int image_index, double min_box_ratio = 0.055,
+                                                int mask_opening = 0);
+    // Detects boxes in a crop of a full_size image that starts at offset. Boxes are returned in full-image
+    // coordinates and the size limits are derived from full_size, so results match a full-frame pass.
+    std::vector<BoundingBox> detect_color_boxes(const cv::Mat& color_roi, const cv::Point& offset, const cv::Size& full_size,
+                                                int image_index, double min_box_ratio = 0.055, int mask_opening = 0);
+    // num_threads == 0 uses one worker per hardware thread.
+    std::vector<BoundingBox> start_pipeline_colors(ConstSpan<cv::Mat> color_images, size_t num_threads = 0);
 }
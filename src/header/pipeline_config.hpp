@@ -0,0 +1,52 @@
+#ifndef PIPELINE_CONFIG_HPP
+#define PIPELINE_CONFIG_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Declarative description of the detection pipeline, loaded from an INI-style file:
+//
+//   [input]
+//   folders = ../traffic_sign_images/vf, ../traffic_sign_images/stop
+//   max_images_per_folder = 100
+//
+//   [stage resized]
+//   type = resize
+//   input = source
+//   factor = 8
+//
+//   [output]
+//   stage = boxes
+//   annotate = resized
+//
+// "source" names the decoded input image; every other input refers to a stage by name.
+namespace pipeline_config {
+
+    struct StageConfig {
+        std::string name;
+        std::string type;
+        std::vector<std::string> inputs;
+        std::map<std::string, std::string> params;
+
+        int get_int(const std::string& key, int fallback) const;
+        double get_double(const std::string& key, double fallback) const;
+        std::string get_string(const std::string& key, const std::string& fallback) const;
+    };
+
+    struct PipelineConfig {
+        std::vector<std::string> folders;
+        int max_images_per_folder = 100;
+        std::vector<StageConfig> stages;
+        std::string output_stage;
+        std::string annotation_stage;   // image stage that output boxes are drawn on, optional
+    };
+
+    // The pipeline that main() runs without a config file.
+    PipelineConfig default_config();
+
+    // Throws std::runtime_error naming the file and line on malformed input.
+    PipelineConfig load_config(const std::string& path);
+}
+
+#endif // PIPELINE_CONFIG_HPP
@@ -0,0 +1,69 @@
+#ifndef PIPELINE_GRAPH_HPP
+#define PIPELINE_GRAPH_HPP
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <map>
+#include <string>
+#include <variant>
+#include <vector>
+#include "../header/bounding_box.hpp"
+#include "../header/pipeline_config.hpp"
+#include "../header/thread_pool.hpp"
+
+namespace pipeline_graph {
+
+    using StageValue = std::variant<cv::Mat, std::vector<BoundingBox>>;
+    using StageFunction = std::function<StageValue(const std::vector<const StageValue*>& inputs, int image_index)>;
+
+    struct GraphResult {
+        std::vector<BoundingBox> bounding_boxes;
+        cv::Mat annotation_image;   // empty unless the config names an annotation stage
+        std::map<std::string, std::vector<BoundingBox>> stage_boxes;    // every box stage, if requested
+    };
+
+    // Per-image execution graph built from a PipelineConfig.
+    // Stage types, input kinds and parameter names are checked when the graph is built. Every stage runs once
+    // per image and its result is shared by all consumers. Stages whose inputs are ready at the same time (e.g.
+    // the color and shape branches) run concurrently as tasks on pool, whose workers keep their scratch buffers
+    // warm; a pool worker running the graph works on queued tasks while it waits for them. Without a pool,
+    // stages run one after another on the calling thread.
+    class PipelineGraph {
+    public:
+        // pool, if given, must outlive the graph.
+        explicit PipelineGraph(const pipeline_config::PipelineConfig& config, ThreadPool* pool = nullptr);
+
+        // Returns the bounding boxes of the output stage and the image of the annotation stage, and with
+        // with_stage_boxes also the boxes of every stage that produces boxes. stage_ms, if given, receives the
+        // wall time of every stage in stage_names() order.
+        GraphResult run(const cv::Mat& source_image, int image_index, bool with_stage_boxes = false,
+                        std::vector<double>* stage_ms = nullptr) const;
+
+        // Returns every stage result, keyed by stage name.
+        std::map<std::string, StageValue> run_stages(const cv::Mat& source_image, int image_index) const;
+
+        // Names of the stages that run, in dependency order; stages the outputs do not need are left out.
+        std::vector<std::string> stage_names() const;
+
+    private:
+        struct Stage {
+            std::string name;
+            const char* profile_name;
+            std::vector<size_t> inputs;     // 0 is the source image, i + 1 is stages[i]
+            StageFunction function;
+        };
+
+        std::vector<StageValue> execute(const cv::Mat& source_image, int image_index, std::vector<double>* stage_ms = nullptr) const;
+
+        std::vector<Stage> stages;     // in dependency order
+        std::vector<std::vector<size_t>> levels;    // stage indices; every input of a level is in an earlier one
+        ThreadPool* pool = nullptr;
+        size_t output_index = 0;
+        size_t annotation_index = 0;
+        bool has_annotation = false;
+    };
+
+    std::vector<std::string> stage_types();
+}
+
+#endif // PIPELINE_GRAPH_HPP
@@ -4,10 +4,26 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include "../header/bounding_box.hpp"
+#include "../header/const_span.hpp"
 
 
 namespace shape_pipeline {
-    std::vector<BoundingBox> start_pipeline_shapes(std::vector<cv::Mat> shape_images);
+    // Boxes smaller than (min_box_ratio * image height)^2 are discarded.
+    std::vector<BoundingBox> detect_shape_boxes(const cv::Mat& shape_image, int image_index, double min_box_ratio = 0.055);
+    // Region variant, see color_pipeline::detect_color_boxes.
+    std::vector<BoundingBox> detect_shape_boxes(const cv::Mat& shape_roi, const cv::Point& offset, const cv::Size& full_size,
+                                                int image_index, double min_box_ratio = 0.055);
+    // Runs edge detection and contour search only inside padded regions around the color candidates of one
+    // resized image; pixels outside every region are never touched. Shape boxes away from every color box
+    // would be dropped by fusion anyway.
+    std::vector<BoundingBox> detect_gated_shape_boxes(const cv::Mat& resized_image, const std::vector<BoundingBox>& color_candidates,
+                                                      int image_index, float padding = 0.5f, int blur_size = 5,
+                                                      int edge_threshold = 30, double min_box_ratio = 0.055);
+    // num_threads == 0 uses one worker per hardware thread.
+    std::vector<BoundingBox> start_pipeline_shapes(ConstSpan<cv::Mat> shape_images, size_t num_threads = 0);
+    // Gated variant of start_pipeline_shapes, taking the resized images and the color-stage boxes of all images.
+    std::vector<BoundingBox> start_pipeline_gated_shapes(ConstSpan<cv::Mat> resized_images,
+                                                         const std::vector<BoundingBox>& color_bounding_boxes, size_t num_threads = 0);
 }
 
 #endif // SHAPE_PIPELINE_HPP
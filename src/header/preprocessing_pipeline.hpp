@@ -2,14 +2,56 @@
 #define PREPROCESSING_PIPELINE_HPP
 
 #include <opencv2/opencv.hpp>
+#include <string>
 #include <vector>
+#include "../header/const_span.hpp"
+#include "../header/packed_dataset.hpp"
 
 namespace pipeline_preprocessing {
 
-    std::vector<cv::Mat> preprocess_resizing(const std::vector<cv::Mat>& images);
-    std::vector<cv::Mat> preprocess_colors(const std::vector<cv::Mat>& images);
-    std::vector<cv::Mat> preprocess_shapes(const std::vector<cv::Mat>& images);
-    std::vector<std::vector<cv::Mat>> start_preprocessing_pipeline();
+    // Owns the three image batches of a preprocessing run; index i of every batch is image i. It can only be
+    // moved, so the batches are handed to the stages as views (ConstSpan) instead of being copied.
+    struct PreprocessedImages {
+        std::vector<cv::Mat> resized_images;
+        std::vector<cv::Mat> color_images;
+        std::vector<cv::Mat> shape_images;
+
+        PreprocessedImages() = default;
+        PreprocessedImages(PreprocessedImages&&) = default;
+        PreprocessedImages& operator=(PreprocessedImages&&) = default;
+        PreprocessedImages(const PreprocessedImages&) = delete;
+        PreprocessedImages& operator=(const PreprocessedImages&) = delete;
+    };
+
+    // Downscale factor the detection stages are tuned for; their box size limits assume it.
+    constexpr int RESIZE_FACTOR = 8;
+
+    cv::Mat preprocess_resizing(const cv::Mat& image, int resize_factor = RESIZE_FACTOR);
+    // Decode and preprocess_resizing in one step: the image is decoded at reduced resolution where the
+    // format allows it (see basic_ops::load_image_scaled). Empty if the file cannot be loaded.
+    cv::Mat load_resized_image(const std::string& image_path, int resize_factor = RESIZE_FACTOR, bool print = true);
+    cv::Mat preprocess_colors(const cv::Mat& image, int median_kernel_size = 5);
+    cv::Mat preprocess_shapes(const cv::Mat& image, int blur_size = 5, int edge_threshold = 30);
+
+    std::vector<cv::Mat> preprocess_resizing(ConstSpan<cv::Mat> images);
+    std::vector<cv::Mat> preprocess_colors(ConstSpan<cv::Mat> images);
+    std::vector<cv::Mat> preprocess_shapes(ConstSpan<cv::Mat> images);
+
+    std::vector<std::string> get_image_folders();
+    // Labeled sub-folders of traffic_sign_images/; "false" holds images that contain no sign.
+    const std::vector<std::string>& get_dataset_labels();
+    std::vector<std::string> get_image_paths();
+    std::vector<std::string> get_image_paths(const std::vector<std::string>& folders, int max_images_per_folder);
+    // If image_paths is given it receives the source path of every returned image, in image-index order.
+    // Without with_shape_images shape_images stays empty, for callers that run gated shape detection.
+    PreprocessedImages start_preprocessing_pipeline(std::vector<std::string>* image_paths = nullptr,
+                                                    bool with_shape_images = true);
+    // Same batches from a packed dataset (see pack_dataset). Stored frames are not copied: the returned
+    // Mats point into the mapping, so dataset must outlive them. Kinds the pack lacks are computed here.
+    // Throws std::runtime_error if the pack was built with a resize factor other than RESIZE_FACTOR.
+    PreprocessedImages start_preprocessing_pipeline(const packed_dataset::PackedDataset& dataset,
+                                                    std::vector<std::string>* image_paths = nullptr,
+                                                    bool with_shape_images = true);
 
 }
 
@@ -0,0 +1,57 @@
+#ifndef PROFILING_HPP
+#define PROFILING_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Scoped wall-time instrumentation for pipeline stages and kernels.
+//
+//   PROFILE_IMAGE_SCOPE("detect_color_boxes", image_index);  // times the enclosing scope for one image
+//   PROFILE_SCOPE("get_blobs");                               // inherits the image of the enclosing image scope
+//   PROFILE_ITEMS(blobs.size());                              // attaches an item count to the current scope
+//
+// Only active when built with IMAGEPROCESSING_PROFILING (CMake option ENABLE_PROFILING); otherwise the
+// macros expand to nothing and their arguments are not evaluated.
+// Scope names must outlive the export; use string literals or profiling::intern().
+namespace profiling {
+
+    bool enabled();
+
+    const char* intern(const std::string& name);
+
+    // Call once the pipeline is idle; events recorded concurrently may be missed.
+    bool write_chrome_trace(const std::string& path);
+    void print_summary(std::ostream& out);
+    void clear();
+
+    class ScopedTimer {
+    public:
+        ScopedTimer(const char* name, int image_index);
+        ~ScopedTimer();
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+        void set_items(int64_t count) { items = count; }
+
+    private:
+        const char* name;
+        int image_index;
+        int previous_image_index;
+        int64_t start_ns;
+        int64_t items = -1;
+    };
+}
+
+#ifdef IMAGEPROCESSING_PROFILING
+#define PROFILE_IMAGE_SCOPE(name, image_index) profiling::ScopedTimer profile_scope((name), (image_index))
+#define PROFILE_SCOPE(name) profiling::ScopedTimer profile_scope((name), -1)
+#define PROFILE_ITEMS(count) profile_scope.set_items(static_cast<int64_t>(count))
+#else
+#define PROFILE_IMAGE_SCOPE(name, image_index) ((void)0)
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_ITEMS(count) ((void)0)
+#endif
+
+#endif // PROFILING_HPP
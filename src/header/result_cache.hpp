@@ -0,0 +1,77 @@
+#ifndef RESULT_CACHE_HPP
+#define RESULT_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../header/bounding_box.hpp"
+#include "../header/pipeline_config.hpp"
+
+// On-disk cache of detection results, addressed by content: the key combines a hash of the encoded image
+// bytes with a hash of the pipeline configuration, so a renamed or copied file still hits and any parameter
+// change misses. Every entry is one file in directory holding the final boxes and the boxes of every stage.
+// When the entries exceed max_bytes the least recently used ones are deleted; use times survive restarts
+// through the file modification times. All members may be called from several threads at once.
+//
+// Only the configuration is part of the key: after changing detection code, clear the directory.
+class ResultCache {
+public:
+    struct Entry {
+        std::vector<BoundingBox> bounding_boxes;
+        std::map<std::string, std::vector<BoundingBox>> stage_boxes;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t stores = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        uint64_t bytes = 0;
+    };
+
+    // Creates directory if needed and indexes the entries already in it.
+    explicit ResultCache(const std::string& directory, uint64_t max_bytes = 256ull << 20);
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    // The cached boxes get image_index, since the same image may appear at another position in this run.
+    std::optional<Entry> lookup(uint64_t image_hash, uint64_t config_hash, int image_index);
+    void store(uint64_t image_hash, uint64_t config_hash, const Entry& entry);
+    // Counts a miss for an image that could not be hashed (e.g. an unreadable file), so the statistics
+    // still add up to the number of images.
+    void record_miss();
+
+    Stats stats() const;
+
+    // 64-bit FNV-1a.
+    static uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 14695981039346656037ull);
+    // Covers the stages with their types, inputs and parameters and the output stage; not the input folders.
+    static uint64_t hash_config(const pipeline_config::PipelineConfig& config);
+
+private:
+    struct IndexedFile {
+        uint64_t bytes;
+        uint64_t last_used;
+    };
+
+    static std::string file_name(uint64_t image_hash, uint64_t config_hash);
+    void evict_locked();
+
+    std::string directory;
+    uint64_t max_bytes;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, IndexedFile> files;     // by file name
+    uint64_t total_bytes = 0;
+    uint64_t use_clock = 0;
+    Stats counters;
+};
+
+#endif // RESULT_CACHE_HPP
@@ -0,0 +1,115 @@
+#ifndef RESULT_STREAM_HPP
+#define RESULT_STREAM_HPP
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../header/bounding_box.hpp"
+
+// Machine-readable detection results, written to a file or named pipe.
+//
+// Binary format (host byte order): a 16-byte StreamHeader followed by 64-byte records.
+//   SOURCE records introduce a source path once; the path bytes follow in
+//          ceil(path_length / 64) raw records, zero padded.
+//   IMAGE  records start the results of one image and carry its box count.
+//   BOX    records follow their IMAGE record, one per bounding box.
+// JSON Lines format: one object per image,
+//   {"source": ..., "image_index": ..., "boxes": [{"center_y": ..., ..., "color": [b, g, r], "shape": ...}]}
+namespace result_stream {
+
+    enum class Format { Binary, JsonLines };
+
+    enum RecordType : uint8_t { SOURCE = 1, IMAGE = 2, BOX = 3 };
+
+    enum ShapeCode : uint8_t { UNKNOWN_SHAPE = 0, TRIANGLE = 1, RECTANGLE = 2, CIRCLE = 3 };
+
+    constexpr size_t record_size = 64;
+    constexpr uint16_t format_version = 1;
+
+    struct StreamHeader {
+        char magic[4];              // "TSBX"
+        uint16_t version;
+        uint16_t record_size;
+        uint8_t reserved[8];
+    };
+
+    struct SourceRecord {
+        uint8_t type;               // SOURCE
+        uint8_t reserved[3];
+        uint32_t source_id;
+        uint32_t path_length;
+        uint8_t padding[52];
+    };
+
+    struct ImageRecord {
+        uint8_t type;               // IMAGE
+        uint8_t reserved[3];
+        uint32_t source_id;
+        int32_t image_index;
+        uint32_t box_count;
+        uint8_t padding[48];
+    };
+
+    struct BoxRecord {
+        uint8_t type;               // BOX
+        uint8_t shape;              // ShapeCode
+        uint8_t color[3];           // B, G, R
+        uint8_t reserved[3];
+        uint32_t source_id;
+        int32_t image_index;
+        int32_t center_y;
+        int32_t center_x;
+        int32_t top;
+        int32_t left;
+        int32_t bottom;
+        int32_t right;
+        int32_t height;
+        int32_t width;
+        int32_t area;
+        uint8_t padding[12];
+    };
+
+    static_assert(sizeof(StreamHeader) == 16, "StreamHeader must stay 16 bytes");
+    static_assert(sizeof(SourceRecord) == record_size, "SourceRecord must be one record");
+    static_assert(sizeof(ImageRecord) == record_size, "ImageRecord must be one record");
+    static_assert(sizeof(BoxRecord) == record_size, "BoxRecord must be one record");
+
+    ShapeCode shape_code(const std::string& shape);
+    std::string shape_name(uint8_t shape_code);
+
+    BoxRecord to_box_record(const BoundingBox& bounding_box, uint32_t source_id, int image_index);
+    BoundingBox from_box_record(const BoxRecord& record);
+
+    Format parse_format(const std::string& name);
+
+    // Buffers encoded results and writes them out in batches of at least flush_bytes.
+    class Writer {
+    public:
+        Writer(const std::string& path, Format format, size_t flush_bytes = 64 * 1024);
+        ~Writer();
+
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        bool is_open() const { return file != nullptr; }
+
+        void write(const std::string& source_path, int image_index, const std::vector<BoundingBox>& bounding_boxes);
+        void flush();
+
+    private:
+        uint32_t get_source_id(const std::string& source_path);
+        void append(const void* data, size_t size);
+        void write_binary(uint32_t source_id, int image_index, const std::vector<BoundingBox>& bounding_boxes);
+        void write_json(const std::string& source_path, int image_index, const std::vector<BoundingBox>& bounding_boxes);
+
+        std::FILE* file = nullptr;
+        Format format;
+        size_t flush_bytes;
+        std::vector<char> buffer;
+        std::unordered_map<std::string, uint32_t> source_ids;
+    };
+}
+
+#endif // RESULT_STREAM_HPP
@@ -0,0 +1,74 @@
+#ifndef SCRATCH_BUFFERS_HPP
+#define SCRATCH_BUFFERS_HPP
+
+#include <opencv2/opencv.hpp>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+// Per-thread scratch memory for per-image intermediates. Every worker thread owns one buffer per slot;
+// buffers only ever grow, so once a thread has seen the largest frame no stage allocates on the hot path.
+//
+// mat() returns a non-owning header onto the slot's buffer. It stays valid until the same slot is requested
+// again on the same thread, so never return it from a stage or keep it across frames; clone() what must
+// outlive the call. OpenCV functions that write into a scratch Mat of the right size and type reuse it.
+namespace scratch {
+
+    enum Slot {
+        COLOR_MASK_0, COLOR_MASK_1, COLOR_MASK_2, COLOR_MASK_3,
+        BLOB_LABELS,
+        SHAPE_GRAY, SOBEL_X, SOBEL_Y, SOBEL_MAGNITUDE,
+        FILTER_PADDED,
+        MORPHOLOGY_ROWS, MORPHOLOGY_FORWARD, MORPHOLOGY_BACKWARD,
+        SLOT_COUNT
+    };
+
+    enum VectorSlot {
+        BLOB_STACK,
+        COLOR_BLOBS,
+        SPARE_BLOBS,
+        FILTER_SUMS,
+        CONVOLUTION_ROWS,
+        MEDIAN_HISTOGRAMS,
+        MORPHOLOGY_LINE,
+        VECTOR_SLOT_COUNT
+    };
+
+    cv::Mat mat(Slot slot, int rows, int cols, int type);
+
+    inline cv::Mat mat(Slot slot, const cv::Size& size, int type) {
+        return mat(slot, size.height, size.width, type);
+    }
+
+    // Bytes currently held by this thread's mat slots.
+    size_t reserved_bytes();
+
+    // The calling thread's vector for slot, with its contents from the last use; clear() keeps the capacity.
+    template <typename T>
+    std::vector<T>& vector(VectorSlot slot) {
+        thread_local std::array<std::vector<T>, VECTOR_SLOT_COUNT> vectors;
+        return vectors[slot];
+    }
+
+    // Resizes outer to count. Inner vectors that are no longer needed are parked in a per-thread spare list
+    // and handed out again later, so their capacity survives frames with fewer entries.
+    template <typename T>
+    void resize_keeping_capacity(std::vector<std::vector<T>>& outer, size_t count) {
+        std::vector<std::vector<T>>& spare = vector<std::vector<T>>(SPARE_BLOBS);
+        while (outer.size() > count) {
+            spare.push_back(std::move(outer.back()));
+            outer.pop_back();
+        }
+        while (outer.size() < count) {
+            if (spare.empty()) {
+                outer.emplace_back();
+            } else {
+                outer.push_back(std::move(spare.back()));
+                spare.pop_back();
+            }
+            outer.back().clear();
+        }
+    }
+}
+
+#endif // SCRATCH_BUFFERS_HPP
@@ -0,0 +1,27 @@
+#ifndef SEQUENCE_PIPELINE_HPP
+#define SEQUENCE_PIPELINE_HPP
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "../header/streaming_pipeline.hpp"
+
+namespace sequence_pipeline {
+
+    struct SequenceOptions {
+        int rescan_interval = 10;     // every rescan_interval-th frame is searched in full
+        float roi_padding = 0.5f;     // region margin per side, relative to the tracked box size
+        int max_misses = 2;           // frames a track survives without a matching detection
+        size_t window_size = 4;       // frames decoded ahead of detection
+    };
+
+    // Treats image_paths as consecutive frames of one sequence. Boxes are tracked from frame to frame with a
+    // BoxTracker; in between full re-scans only the predicted regions are preprocessed and searched, so the
+    // per-frame cost follows the number of signs instead of the resolution. Frames without any live track
+    // are always searched in full.
+    void start_sequence_pipeline(const std::vector<std::string>& image_paths, const SequenceOptions& options,
+                                 const std::function<void(const streaming_pipeline::ImageResult&)>& on_result);
+
+}
+
+#endif // SEQUENCE_PIPELINE_HPP
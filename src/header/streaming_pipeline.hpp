@@ -0,0 +1,28 @@
+#ifndef STREAMING_PIPELINE_HPP
+#define STREAMING_PIPELINE_HPP
+
+#include <opencv2/opencv.hpp>
+#include <functional>
+#include <string>
+#include <vector>
+#include "../header/bounding_box.hpp"
+
+namespace streaming_pipeline {
+
+    struct ImageResult {
+        int image_index;
+        std::string source_path;
+        cv::Mat resized_image;
+        std::vector<BoundingBox> bounding_boxes;
+    };
+
+    // Runs preprocess -> colors -> shapes -> fusion on one image at a time.
+    // Files are decoded in parallel by an ImageLoader and preprocessed on a loader thread, each at most
+    // window_size images ahead, so memory stays bounded and on_result is called as soon as each image is done.
+    // With gate_shapes, shape detection only runs around the color candidates (see detect_gated_shape_boxes).
+    void start_streaming_pipeline(const std::vector<std::string>& image_paths, size_t window_size,
+                                  const std::function<void(const ImageResult&)>& on_result, bool gate_shapes = false);
+
+}
+
+#endif // STREAMING_PIPELINE_HPP
@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Every worker owns a task deque: it takes work from the back of its own
+// deque and, once that is empty, steals from the front of the others.
+class ThreadPool {
+public:
+    // num_threads == 0 uses std::thread::hardware_concurrency().
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return threads.size(); }
+
+    void submit(std::function<void()> task);
+
+    // Runs body(0) ... body(count - 1) on the workers and blocks until all calls have returned.
+    // The first exception thrown by body is rethrown on the calling thread.
+    // May be called from inside one of this pool's own tasks: the calling worker then runs queued tasks
+    // until the calls are done instead of blocking, so nested calls cannot leave every worker waiting.
+    void parallel_for(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    struct Worker {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    bool take_task(size_t worker_index, std::function<void()>& task);
+    void worker_loop(size_t worker_index);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<size_t> queued_tasks{0};
+    std::atomic<size_t> next_worker{0};
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+#endif // THREAD_POOL_HPP
@@ -0,0 +1,85 @@
+#include "header/image_loader.hpp"
+#include "header/basic_image_operations.hpp"
+#include "header/profiling.hpp"
+#include <algorithm>
+#include <iostream>
+
+ImageLoader::ImageLoader(std::vector<std::string> image_paths, size_t num_threads, size_t prefetch, DecodeFunction decode)
+    : image_paths(std::move(image_paths)), prefetch(std::max<size_t>(1, prefetch)), decode(std::move(decode)) {
+    if (!this->decode) {
+        this->decode = [](const std::string& image_path) { return basic_ops::load_image(image_path, true); };
+    }
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    // More threads than prefetch slots would only wait for a free slot.
+    num_threads = std::min({num_threads, this->prefetch, std::max<size_t>(1, this->image_paths.size())});
+    for (size_t i = 0; i < num_threads; i++) {
+        threads.emplace_back([this] { decode_loop(); });
+    }
+}
+
+ImageLoader::~ImageLoader() {
+    close();
+}
+
+void ImageLoader::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        decoded.clear();
+    }
+    slot_free.notify_all();
+    image_ready.notify_all();
+    for (auto& thread : threads) {
+        if (thread.joinable()) thread.join();
+    }
+}
+
+void ImageLoader::decode_loop() {
+    while (true) {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // An image counts against the prefetch window from the moment a thread starts decoding it.
+            slot_free.wait(lock, [this] {
+                return closed || next_to_decode >= image_paths.size() || next_to_decode < next_to_deliver + prefetch;
+            });
+            if (closed || next_to_decode >= image_paths.size()) return;
+            index = next_to_decode++;
+        }
+
+        cv::Mat image;
+        {
+            PROFILE_IMAGE_SCOPE("prefetch_decode", static_cast<int>(index));
+            try {
+                image = decode(image_paths[index]);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Unable to decode " << image_paths[index] << ": " << e.what() << std::endl;
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (closed) return;
+            decoded.emplace(index, std::move(image));
+        }
+        image_ready.notify_all();
+    }
+}
+
+std::optional<ImageLoader::LoadedImage> ImageLoader::next() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!closed && next_to_deliver < image_paths.size()) {
+        size_t index = next_to_deliver;
+        image_ready.wait(lock, [this, index] { return closed || decoded.count(index) > 0; });
+        if (closed) break;
+
+        auto it = decoded.find(index);
+        cv::Mat image = std::move(it->second);
+        decoded.erase(it);
+        next_to_deliver++;
+        slot_free.notify_all();
+        if (image.empty()) continue;
+        return LoadedImage{index, image_paths[index], std::move(image)};
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,41 @@
+#include "header/image_writer.hpp"
+#include "header/basic_image_operations.hpp"
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+AnnotatedImageWriter::AnnotatedImageWriter(const std::string& output_dir, size_t max_pending)
+    : output_dir(output_dir), pending(max_pending) {
+    fs::create_directories(output_dir);
+    writer = std::thread([this] { write_loop(); });
+}
+
+AnnotatedImageWriter::~AnnotatedImageWriter() {
+    close();
+}
+
+bool AnnotatedImageWriter::enqueue(const cv::Mat& image, std::vector<BoundingBox> bounding_boxes, const std::string& file_name,
+                                   bool wait_when_full) {
+    PendingImage item{image.clone(), std::move(bounding_boxes), file_name};
+    bool queued = wait_when_full ? pending.push(std::move(item)) : pending.try_push(std::move(item));
+    if (!queued) {
+        dropped_count.fetch_add(1);
+        return false;
+    }
+    return true;
+}
+
+void AnnotatedImageWriter::close() {
+    pending.close();
+    if (writer.joinable()) writer.join();
+}
+
+void AnnotatedImageWriter::write_loop() {
+    while (std::optional<PendingImage> item = pending.pop()) {
+        for (const auto& bounding_box : item->bounding_boxes) {
+            bounding_box::draw_bounding_box(bounding_box, item->image);
+        }
+        basic_ops::save_image(item->image, (fs::path(output_dir) / item->file_name).string(), false);
+        written_count.fetch_add(1);
+    }
+}
@@ -0,0 +1,139 @@
+#include "header/morphology.hpp"
+#include "header/scratch_buffers.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace morphology {
+    namespace {
+        struct Min {
+            static constexpr uchar identity = 255;
+            static uchar apply(uchar a, uchar b) { return std::min(a, b); }
+        };
+
+        struct Max {
+            static constexpr uchar identity = 0;
+            static uchar apply(uchar a, uchar b) { return std::max(a, b); }
+        };
+
+        // van Herk / Gil-Werman: the replicate-padded line is cut into blocks of dim elements, forward holds the
+        // running extremum from the start of each block and backward the one from its end. A window of dim
+        // elements starting at i covers the tail of one block and the head of the next, so its extremum is
+        // Op(backward[i], forward[i + dim - 1]). Elements are `width` bytes wide and compared bytewise: pixels
+        // for the row pass, whole rows for the column pass, so every inner loop runs over contiguous bytes.
+
+        // Row pass over every image row; pixels of `channels` bytes are the elements.
+        template <typename Op>
+        void row_pass(const cv::Mat& src, int dim, cv::Mat& dst) {
+            const int cols = src.cols, channels = src.channels(), pad = dim / 2;
+            const int padded_cols = cols + dim - 1;
+            const size_t length = static_cast<size_t>((padded_cols + dim - 1) / dim * dim) * channels;
+            const size_t block = static_cast<size_t>(dim) * channels;
+
+            std::vector<uchar>& buffer = scratch::vector<uchar>(scratch::MORPHOLOGY_LINE);
+            buffer.resize(3 * length);
+            uchar* line = buffer.data();
+            uchar* forward = line + length;
+            uchar* backward = forward + length;
+            std::fill(line + static_cast<size_t>(padded_cols) * channels, line + length, Op::identity);
+
+            for (int y = 0; y < src.rows; ++y) {
+                const uchar* in = src.ptr<uchar>(y);
+                for (int x = 0; x < pad; ++x) std::memcpy(line + x * channels, in, channels);
+                std::memcpy(line + pad * channels, in, static_cast<size_t>(cols) * channels);
+                for (int x = pad + cols; x < padded_cols; ++x) std::memcpy(line + x * channels, in + (cols - 1) * channels, channels);
+
+                for (size_t start = 0; start < length; start += block) {
+                    const size_t end = start + block;
+                    std::memcpy(forward + start, line + start, channels);
+                    for (size_t i = start + channels; i < end; ++i) forward[i] = Op::apply(forward[i - channels], line[i]);
+                    std::memcpy(backward + end - channels, line + end - channels, channels);
+                    for (size_t i = end - channels; i-- > start;) backward[i] = Op::apply(backward[i + channels], line[i]);
+                }
+
+                uchar* out = dst.ptr<uchar>(y);
+                const uchar* window_end = forward + block - channels;
+                for (size_t i = 0; i < static_cast<size_t>(cols) * channels; ++i) out[i] = Op::apply(backward[i], window_end[i]);
+            }
+        }
+
+        // Column pass; whole rows are the elements.
+        template <typename Op>
+        void column_pass(const cv::Mat& src, int dim, cv::Mat& dst) {
+            const int rows = src.rows, width = src.cols * src.channels(), pad = dim / 2;
+            const int padded_rows = rows + dim - 1;
+            const int length = (padded_rows + dim - 1) / dim * dim;
+
+            cv::Mat forward = scratch::mat(scratch::MORPHOLOGY_FORWARD, length, width, CV_8UC1);
+            cv::Mat backward = scratch::mat(scratch::MORPHOLOGY_BACKWARD, length, width, CV_8UC1);
+            std::vector<uchar>& identity_row = scratch::vector<uchar>(scratch::MORPHOLOGY_LINE);
+            identity_row.assign(width, Op::identity);
+            auto padded_row = [&](int r) {
+                return r < padded_rows ? src.ptr<uchar>(std::clamp(r - pad, 0, rows - 1)) : identity_row.data();
+            };
+
+            for (int start = 0; start < length; start += dim) {
+                const int end = start + dim;
+                std::memcpy(forward.ptr<uchar>(start), padded_row(start), width);
+                for (int r = start + 1; r < end; ++r) {
+                    const uchar* previous = forward.ptr<uchar>(r - 1);
+                    const uchar* in = padded_row(r);
+                    uchar* out = forward.ptr<uchar>(r);
+                    for (int i = 0; i < width; ++i) out[i] = Op::apply(previous[i], in[i]);
+                }
+                std::memcpy(backward.ptr<uchar>(end - 1), padded_row(end - 1), width);
+                for (int r = end - 2; r >= start; --r) {
+                    const uchar* next = backward.ptr<uchar>(r + 1);
+                    const uchar* in = padded_row(r);
+                    uchar* out = backward.ptr<uchar>(r);
+                    for (int i = 0; i < width; ++i) out[i] = Op::apply(next[i], in[i]);
+                }
+            }
+
+            for (int y = 0; y < rows; ++y) {
+                const uchar* window_start = backward.ptr<uchar>(y);
+                const uchar* window_end = forward.ptr<uchar>(y + dim - 1);
+                uchar* out = dst.ptr<uchar>(y);
+                for (int i = 0; i < width; ++i) out[i] = Op::apply(window_start[i], window_end[i]);
+            }
+        }
+
+        template <typename Op>
+        cv::Mat extremum_filter(const cv::Mat& image, int dim) {
+            CV_Assert(image.depth() == CV_8U && dim > 0);
+            cv::Mat output(image.size(), image.type());
+            if (image.empty()) return output;
+            cv::Mat rows_done = scratch::mat(scratch::MORPHOLOGY_ROWS, image.size(), image.type());
+            row_pass<Op>(image, dim, rows_done);
+            column_pass<Op>(rows_done, dim, output);
+            return output;
+        }
+    }
+
+    cv::Mat erode(const cv::Mat& image, int dim) {
+        return extremum_filter<Min>(image, dim);
+    }
+
+    cv::Mat dilate(const cv::Mat& image, int dim) {
+        return extremum_filter<Max>(image, dim);
+    }
+
+    cv::Mat opening(const cv::Mat& image, int dim) {
+        return dilate(erode(image, dim), dim);
+    }
+
+    cv::Mat closing(const cv::Mat& image, int dim) {
+        return erode(dilate(image, dim), dim);
+    }
+
+    cv::Mat gradient(const cv::Mat& image, int dim) {
+        cv::Mat output;
+        cv::subtract(dilate(image, dim), erode(image, dim), output);
+        return output;
+    }
+
+    cv::Mat top_hat(const cv::Mat& image, int dim) {
+        cv::Mat output;
+        cv::subtract(image, opening(image, dim), output);
+        return output;
+    }
+}
@@ -0,0 +1,167 @@
+#include "header/packed_dataset.hpp"
+#include "header/preprocessing_pipeline.hpp"
+#include "header/profiling.hpp"
+#include "header/thread_pool.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace packed_dataset {
+    namespace {
+        struct PreparedImage {
+            std::string source_path;
+            cv::Mat frames[FRAME_KIND_COUNT];
+        };
+
+        void write_padding(std::ofstream& file, size_t alignment) {
+            static const char zeros[block_alignment] = {};
+            size_t misalignment = static_cast<size_t>(file.tellp()) % alignment;
+            if (misalignment != 0) file.write(zeros, static_cast<std::streamsize>(alignment - misalignment));
+        }
+
+        FrameRecord write_frame(std::ofstream& file, const cv::Mat& frame) {
+            write_padding(file, block_alignment);
+            FrameRecord record{};
+            record.offset = static_cast<uint64_t>(file.tellp());
+            record.rows = frame.rows;
+            record.cols = frame.cols;
+            record.type = frame.type();
+            size_t row_bytes = frame.cols * frame.elemSize();
+            for (int y = 0; y < frame.rows; y++) {
+                file.write(reinterpret_cast<const char*>(frame.ptr(y)), static_cast<std::streamsize>(row_bytes));
+            }
+            return record;
+        }
+    }
+
+    size_t pack_images(const std::vector<std::string>& image_paths, const std::string& output_path, const PackOptions& options) {
+        std::ofstream file(output_path, std::ios::binary | std::ios::trunc);
+        if (!file) throw std::runtime_error("Unable to write " + output_path);
+
+        // Only zeros go in the header slot for now; magic and version are written at the very end.
+        FileHeader header{};
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        header.frame_kinds = options.frame_kinds | frame_bit(RESIZED);
+        header.resize_factor = options.resize_factor;
+
+        // Images are prepared a chunk at a time in parallel and written in order, so memory stays bounded.
+        ThreadPool pool(options.num_threads);
+        size_t chunk_size = pool.size() * 4;
+        std::vector<IndexEntry> entries;
+        std::vector<std::string> packed_paths;
+        for (size_t chunk_start = 0; chunk_start < image_paths.size(); chunk_start += chunk_size) {
+            size_t chunk_end = std::min(image_paths.size(), chunk_start + chunk_size);
+            std::vector<PreparedImage> chunk(chunk_end - chunk_start);
+            pool.parallel_for(chunk.size(), [&](size_t i) {
+                PROFILE_IMAGE_SCOPE("pack_image", static_cast<int>(chunk_start + i));
+                PreparedImage& prepared = chunk[i];
+                prepared.source_path = image_paths[chunk_start + i];
+                cv::Mat resized_image = pipeline_preprocessing::load_resized_image(prepared.source_path, options.resize_factor, false);
+                if (resized_image.empty()) return;
+                if (header.frame_kinds & frame_bit(COLOR)) {
+                    prepared.frames[COLOR] = pipeline_preprocessing::preprocess_colors(resized_image);
+                }
+                if (header.frame_kinds & frame_bit(SHAPE)) {
+                    prepared.frames[SHAPE] = pipeline_preprocessing::preprocess_shapes(resized_image);
+                }
+                prepared.frames[RESIZED] = std::move(resized_image);
+            });
+
+            for (const auto& prepared : chunk) {
+                if (prepared.frames[RESIZED].empty()) continue;
+                IndexEntry entry{};
+                for (uint32_t kind = 0; kind < FRAME_KIND_COUNT; kind++) {
+                    if (!prepared.frames[kind].empty()) entry.frames[kind] = write_frame(file, prepared.frames[kind]);
+                }
+                entries.push_back(entry);
+                packed_paths.push_back(prepared.source_path);
+            }
+        }
+
+        write_padding(file, block_alignment);
+        header.index_offset = static_cast<uint64_t>(file.tellp());
+        header.image_count = static_cast<uint32_t>(entries.size());
+        uint64_t path_offset = header.index_offset + entries.size() * sizeof(IndexEntry);
+        for (size_t i = 0; i < entries.size(); i++) {
+            entries[i].path_offset = path_offset;
+            entries[i].path_length = static_cast<uint32_t>(packed_paths[i].size());
+            path_offset += packed_paths[i].size();
+        }
+        file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+        for (const auto& path : packed_paths) {
+            file.write(path.data(), static_cast<std::streamsize>(path.size()));
+        }
+
+        // The header is written last, so a pack that was cut short has no magic and is rejected by the reader.
+        std::memcpy(header.magic, "TSPK", 4);
+        header.version = format_version;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.flush();
+        if (!file) throw std::runtime_error("Unable to write " + output_path);
+        return entries.size();
+    }
+
+    PackedDataset::PackedDataset(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Unable to open " + path);
+        struct stat file_stat{};
+        if (::fstat(fd, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < sizeof(FileHeader)) {
+            ::close(fd);
+            throw std::runtime_error("Not a packed dataset: " + path);
+        }
+        file_size = static_cast<size_t>(file_stat.st_size);
+        // Private and writable: frames can be modified in place without touching the file (copy-on-write pages).
+        void* mapping = ::mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) throw std::runtime_error("Unable to map " + path);
+        data = static_cast<uint8_t*>(mapping);
+
+        header = reinterpret_cast<const FileHeader*>(data);
+        bool valid = std::memcmp(header->magic, "TSPK", 4) == 0 && header->version == format_version &&
+                     header->index_offset % alignof(IndexEntry) == 0 && header->index_offset >= sizeof(FileHeader) &&
+                     header->index_offset <= file_size &&
+                     (file_size - header->index_offset) / sizeof(IndexEntry) >= header->image_count;
+        if (valid) {
+            index = reinterpret_cast<const IndexEntry*>(data + header->index_offset);
+            for (size_t i = 0; i < header->image_count && valid; i++) {
+                const IndexEntry& image_entry = index[i];
+                valid = image_entry.path_offset <= file_size && image_entry.path_length <= file_size - image_entry.path_offset;
+                for (uint32_t kind = 0; kind < FRAME_KIND_COUNT && valid; kind++) {
+                    const FrameRecord& record = image_entry.frames[kind];
+                    if (record.offset == 0) continue;
+                    uint64_t bytes = static_cast<uint64_t>(record.rows) * record.cols * CV_ELEM_SIZE(record.type);
+                    valid = record.rows > 0 && record.cols > 0 && record.offset <= file_size && bytes <= file_size - record.offset;
+                }
+            }
+        }
+        if (!valid) {
+            ::munmap(data, file_size);
+            throw std::runtime_error("Not a valid packed dataset: " + path);
+        }
+    }
+
+    PackedDataset::~PackedDataset() {
+        ::munmap(data, file_size);
+    }
+
+    const IndexEntry& PackedDataset::entry(size_t image_index) const {
+        CV_Assert(image_index < size());
+        return index[image_index];
+    }
+
+    std::string PackedDataset::source_path(size_t image_index) const {
+        const IndexEntry& image_entry = entry(image_index);
+        return std::string(reinterpret_cast<const char*>(data + image_entry.path_offset), image_entry.path_length);
+    }
+
+    cv::Mat PackedDataset::frame(size_t image_index, FrameKind kind) const {
+        const FrameRecord& record = entry(image_index).frames[kind];
+        if (record.offset == 0) return {};
+        return cv::Mat(record.rows, record.cols, record.type, data + record.offset);
+    }
+}
@@ -0,0 +1,171 @@
+#include "header/pipeline_config.hpp"
+#include "header/preprocessing_pipeline.hpp"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace pipeline_config {
+    namespace {
+        std::string trim(const std::string& text) {
+            size_t begin = text.find_first_not_of(" \t\r");
+            if (begin == std::string::npos) return "";
+            size_t end = text.find_last_not_of(" \t\r");
+            return text.substr(begin, end - begin + 1);
+        }
+
+        std::vector<std::string> split_list(const std::string& text) {
+            std::vector<std::string> items;
+            std::stringstream ss(text);
+            std::string item;
+            while (std::getline(ss, item, ',')) {
+                item = trim(item);
+                if (!item.empty()) items.push_back(item);
+            }
+            return items;
+        }
+
+        StageConfig make_stage(const std::string& name, const std::string& type, std::vector<std::string> inputs,
+                               std::map<std::string, std::string> params) {
+            StageConfig stage;
+            stage.name = name;
+            stage.type = type;
+            stage.inputs = std::move(inputs);
+            stage.params = std::move(params);
+            return stage;
+        }
+    }
+
+    int StageConfig::get_int(const std::string& key, int fallback) const {
+        auto it = params.find(key);
+        if (it == params.end()) return fallback;
+        try {
+            return std::stoi(it->second);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Stage '" + name + "': " + key + " must be an integer, got '" + it->second + "'");
+        }
+    }
+
+    double StageConfig::get_double(const std::string& key, double fallback) const {
+        auto it = params.find(key);
+        if (it == params.end()) return fallback;
+        try {
+            return std::stod(it->second);
+        } catch (const std::exception&) {
+            throw std::runtime_error("Stage '" + name + "': " + key + " must be a number, got '" + it->second + "'");
+        }
+    }
+
+    std::string StageConfig::get_string(const std::string& key, const std::string& fallback) const {
+        auto it = params.find(key);
+        return it == params.end() ? fallback : it->second;
+    }
+
+    PipelineConfig default_config() {
+        PipelineConfig config;
+        config.folders = pipeline_preprocessing::get_image_folders();
+        config.max_images_per_folder = 100;
+        config.stages = {
+            make_stage("resized", "resize", {"source"}, {{"factor", "8"}}),
+            make_stage("color_image", "median_blur", {"resized"}, {{"kernel_size", "5"}}),
+            make_stage("shape_image", "edges", {"resized"}, {{"blur_size", "5"}, {"threshold", "30"}}),
+            make_stage("color_boxes", "color_boxes", {"color_image"}, {{"min_box_ratio", "0.055"}, {"merge_deviation", "10"}}),
+            make_stage("shape_boxes", "shape_boxes", {"shape_image"}, {{"min_box_ratio", "0.055"}, {"merge_deviation", "10"}}),
+            make_stage("boxes", "fuse", {"color_boxes", "shape_boxes"}, {{"match_deviation", "15"}, {"merge_deviation", "20"}}),
+        };
+        config.output_stage = "boxes";
+        config.annotation_stage = "resized";
+        return config;
+    }
+
+    PipelineConfig load_config(const std::string& path) {
+        std::ifstream file(path);
+        if (!file) {
+            throw std::runtime_error("Unable to open pipeline config " + path);
+        }
+
+        PipelineConfig config;
+        std::string section;
+        StageConfig* stage = nullptr;
+        std::string line;
+        int line_number = 0;
+
+        auto fail = [&](const std::string& message) {
+            throw std::runtime_error(path + ":" + std::to_string(line_number) + ": " + message);
+        };
+
+        while (std::getline(file, line)) {
+            ++line_number;
+            size_t comment = line.find_first_of("#;");
+            if (comment != std::string::npos) line.erase(comment);
+            line = trim(line);
+            if (line.empty()) continue;
+
+            if (line.front() == '[') {
+                if (line.back() != ']') fail("unterminated section header");
+                std::string header = trim(line.substr(1, line.size() - 2));
+                stage = nullptr;
+                if (header.compare(0, 6, "stage ") == 0) {
+                    std::string name = trim(header.substr(5));
+                    if (name.empty() || name == "source") fail("invalid stage name '" + name + "'");
+                    for (const auto& existing : config.stages) {
+                        if (existing.name == name) fail("duplicate stage '" + name + "'");
+                    }
+                    config.stages.push_back(StageConfig());
+                    stage = &config.stages.back();
+                    stage->name = name;
+                    section = "stage";
+                } else if (header == "input" || header == "output") {
+                    section = header;
+                } else {
+                    fail("unknown section [" + header + "]");
+                }
+                continue;
+            }
+
+            size_t equals = line.find('=');
+            if (equals == std::string::npos) fail("expected key = value");
+            std::string key = trim(line.substr(0, equals));
+            std::string value = trim(line.substr(equals + 1));
+
+            if (section == "input") {
+                if (key == "folders") {
+                    config.folders = split_list(value);
+                } else if (key == "max_images_per_folder") {
+                    try {
+                        config.max_images_per_folder = std::stoi(value);
+                    } catch (const std::exception&) {
+                        fail("max_images_per_folder must be an integer");
+                    }
+                } else {
+                    fail("unknown input key '" + key + "'");
+                }
+            } else if (section == "output") {
+                if (key == "stage") {
+                    config.output_stage = value;
+                } else if (key == "annotate") {
+                    config.annotation_stage = value;
+                } else {
+                    fail("unknown output key '" + key + "'");
+                }
+            } else if (section == "stage") {
+                if (key == "type") {
+                    stage->type = value;
+                } else if (key == "input" || key == "inputs") {
+                    stage->inputs = split_list(value);
+                } else {
+                    stage->params[key] = value;
+                }
+            } else {
+                fail("key outside of a section");
+            }
+        }
+
+        if (config.stages.empty()) {
+            throw std::runtime_error(path + ": no stages declared");
+        }
+        if (config.output_stage.empty()) {
+            config.output_stage = config.stages.back().name;
+        }
+        return config;
+    }
+}
@@ -3,20 +3,266 @@
 #include "../header/pipeline_colors.hpp"
 #include "../header/pipeline_shapes.hpp"
 #include "../header/pipeline_box_fusion.hpp"
+#include "../header/streaming_pipeline.hpp"
+#include "../header/sequence_pipeline.hpp"
+#include "../header/colors.hpp"
+#include "../header/image_writer.hpp"
+#include "../header/result_stream.hpp"
+#include "../header/pipeline_config.hpp"
+#include "../header/detector.hpp"
+#include "../header/detection_server.hpp"
+#include "../header/packed_dataset.hpp"
+#include "../header/result_cache.hpp"
+#include "../header/profiling.hpp"
 
 #include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <csignal>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
 
 #include "../header/preprocessing_pipeline.hpp"
 
-int main() {
+// Runs the pipeline declared in a config file over its input folders, a few images per worker at a time,
+// and reports results in image-index order.
+void run_config_pipeline(const pipeline_config::PipelineConfig& config, size_t num_threads,
+                         result_stream::Writer* result_writer, AnnotatedImageWriter* image_writer,
+                         ResultCache* result_cache) {
+    Detector detector(config, num_threads);
+    std::vector<std::string> image_paths = pipeline_preprocessing::get_image_paths(config.folders, config.max_images_per_folder);
 
-    std::vector<std::vector<cv::Mat>> images = pipeline_preprocessing::start_preprocessing_pipeline();
-    std::vector<cv::Mat> resized_images = images[0];
-    std::vector<cv::Mat> color_images = images[1];
-    std::vector<cv::Mat> shape_images = images[2];
+    size_t chunk_size = detector.num_threads() * 2;
+    for (size_t chunk_start = 0; chunk_start < image_paths.size(); chunk_start += chunk_size) {
+        size_t chunk_end = std::min(image_paths.size(), chunk_start + chunk_size);
+        std::vector<pipeline_graph::GraphResult> results = detector.run_files(
+            std::vector<std::string>(image_paths.begin() + chunk_start, image_paths.begin() + chunk_end),
+            static_cast<int>(chunk_start), result_cache);
 
-    std::vector<BoundingBox> color_bounding_boxes = color_pipeline::start_pipeline_colors(color_images);
-    std::vector<BoundingBox> shape_bounding_boxes = shape_pipeline::start_pipeline_shapes(shape_images);
-    std::vector<BoundingBox> bounding_boxes = box_fusion_pipeline::start_pipeline_box_fusion(color_bounding_boxes, shape_bounding_boxes, resized_images);
+        for (size_t i = 0; i < results.size(); i++) {
+            const std::string& image_path = image_paths[chunk_start + i];
+            std::cout << "Bounding Boxes (" << image_path << "): " << results[i].bounding_boxes.size() << std::endl;
+            for (const auto& bbox : results[i].bounding_boxes) {
+                std::cout << bbox.to_string() << std::endl;
+            }
+            if (result_writer) {
+                result_writer->write(image_path, static_cast<int>(chunk_start + i), results[i].bounding_boxes);
+            }
+            if (image_writer && !results[i].annotation_image.empty()) {
+                image_writer->enqueue(results[i].annotation_image, results[i].bounding_boxes,
+                                      std::filesystem::path(image_path).filename().string());
+            }
+        }
+    }
+}
+
+static detection_server::Server* active_server = nullptr;
+
+static void stop_server(int) {
+    if (active_server) active_server->stop();
+}
+
+static int run(int argc, char* argv[]) {
+    bool streaming = false;
+    bool sequence = false;
+    bool gate_shapes = false;
+    sequence_pipeline::SequenceOptions sequence_options;
+    size_t window_size = 4;
+    size_t num_threads = 0;
+    std::string color_lut_path;
+    bool headless = false;
+    std::string output_dir;
+    std::string results_path;
+    std::string config_path;
+    std::string trace_path;
+    std::string packed_path;
+    std::string cache_dir;
+    uint64_t cache_size_mb = 256;
+    detection_server::ServerOptions server_options;
+    result_stream::Format results_format = result_stream::Format::Binary;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--stream") {
+            streaming = true;
+        } else if (arg == "--sequence") {
+            sequence = true;
+        } else if (arg == "--gate-shapes") {
+            gate_shapes = true;
+        } else if (arg == "--rescan" && i + 1 < argc) {
+            sequence_options.rescan_interval = std::stoi(argv[++i]);
+        } else if (arg == "--window" && i + 1 < argc) {
+            window_size = static_cast<size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            num_threads = static_cast<size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--color-lut" && i + 1 < argc) {
+            color_lut_path = argv[++i];
+        } else if (arg == "--headless") {
+            headless = true;
+        } else if (arg == "--output-dir" && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--serve" && i + 1 < argc) {
+            server_options.socket_path = argv[++i];
+        } else if (arg == "--max-batch" && i + 1 < argc) {
+            server_options.max_batch_size = static_cast<size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--max-batch-latency" && i + 1 < argc) {
+            server_options.max_batch_latency_ms = std::stoi(argv[++i]);
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (arg == "--cache-size" && i + 1 < argc) {
+            cache_size_mb = std::stoull(argv[++i]);
+        } else if (arg == "--packed" && i + 1 < argc) {
+            packed_path = argv[++i];
+        } else if (arg == "--config" && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (arg == "--results" && i + 1 < argc) {
+            results_path = argv[++i];
+        } else if (arg == "--results-format" && i + 1 < argc) {
+            results_format = result_stream::parse_format(argv[++i]);
+        }
+    }
+
+    // The packed frames only feed the batch pipeline; every other mode decodes its inputs itself.
+    if (!packed_path.empty() && (!server_options.socket_path.empty() || !config_path.empty() || !cache_dir.empty() ||
+                                 streaming || sequence)) {
+        std::cerr << "Error: --packed cannot be combined with --serve, --config, --cache, --stream or --sequence" << std::endl;
+        return 2;
+    }
+    // The cache is only wired into the config pipeline; the other modes would silently drop it.
+    if (!cache_dir.empty() && (!server_options.socket_path.empty() || streaming || sequence || gate_shapes)) {
+        std::cerr << "Error: --cache cannot be combined with --serve, --stream, --sequence or --gate-shapes" << std::endl;
+        return 2;
+    }
+    // A config describes the whole detection graph; the gated mode is configs/gated_shapes.pipeline.
+    if (!config_path.empty() && (streaming || sequence || gate_shapes)) {
+        std::cerr << "Error: --config cannot be combined with --stream, --sequence or --gate-shapes" << std::endl;
+        return 2;
+    }
+
+    // An existing file has to be a valid LUT; it is never overwritten. A missing one is built and saved.
+    if (!color_lut_path.empty()) {
+        if (std::filesystem::exists(color_lut_path)) {
+            if (!colors::load_color_lut(color_lut_path)) return 1;
+        } else {
+            colors::save_color_lut(color_lut_path);
+        }
+    }
+
+    std::unique_ptr<AnnotatedImageWriter> image_writer;
+    if (!output_dir.empty()) {
+        image_writer = std::make_unique<AnnotatedImageWriter>(output_dir);
+    }
+
+    std::unique_ptr<result_stream::Writer> result_writer;
+    if (!results_path.empty()) {
+        result_writer = std::make_unique<result_stream::Writer>(results_path, results_format);
+    }
+
+    std::unique_ptr<ResultCache> result_cache;
+    if (!cache_dir.empty()) {
+        result_cache = std::make_unique<ResultCache>(cache_dir, cache_size_mb << 20);
+    }
+
+    auto report_result = [&](const streaming_pipeline::ImageResult& result) {
+        std::cout << "Bounding Boxes (" << result.source_path << "): " << result.bounding_boxes.size() << std::endl;
+        for (const auto& bbox : result.bounding_boxes) {
+            std::cout << bbox.to_string() << std::endl;
+        }
+        if (result_writer) {
+            result_writer->write(result.source_path, result.image_index, result.bounding_boxes);
+        }
+        if (image_writer) {
+            image_writer->enqueue(result.resized_image, result.bounding_boxes,
+                                  std::filesystem::path(result.source_path).filename().string());
+        }
+    };
+
+    if (!server_options.socket_path.empty()) {
+        Detector detector(config_path.empty() ? pipeline_config::default_config() : pipeline_config::load_config(config_path),
+                          num_threads);
+        detection_server::Server server(detector, server_options);
+        active_server = &server;
+        std::signal(SIGINT, stop_server);
+        std::signal(SIGTERM, stop_server);
+        server.run();
+        active_server = nullptr;
+        std::cout << "Requests served: " << server.requests_served() << ", batches: " << server.batches_run() << std::endl;
+    } else if (!config_path.empty() || result_cache) {
+        // Cached runs go through the config graph even without --config; the default config is the same pipeline.
+        run_config_pipeline(config_path.empty() ? pipeline_config::default_config() : pipeline_config::load_config(config_path),
+                            num_threads, result_writer.get(), image_writer.get(), result_cache.get());
+    } else if (sequence) {
+        // Frames are expected to be named in playback order.
+        std::vector<std::string> frame_paths = pipeline_preprocessing::get_image_paths();
+        std::sort(frame_paths.begin(), frame_paths.end());
+        sequence_options.window_size = window_size;
+        sequence_pipeline::start_sequence_pipeline(frame_paths, sequence_options, report_result);
+    } else if (streaming) {
+        streaming_pipeline::start_streaming_pipeline(pipeline_preprocessing::get_image_paths(), window_size, report_result, gate_shapes);
+    } else {
+        std::vector<std::string> image_paths;
+        // The packed frames are mapped, not copied, so the dataset has to stay open until the end of the run.
+        std::unique_ptr<packed_dataset::PackedDataset> packed;
+        if (!packed_path.empty()) packed = std::make_unique<packed_dataset::PackedDataset>(packed_path);
+        pipeline_preprocessing::PreprocessedImages images = packed
+            ? pipeline_preprocessing::start_preprocessing_pipeline(*packed, &image_paths, !gate_shapes)
+            : pipeline_preprocessing::start_preprocessing_pipeline(&image_paths, !gate_shapes);
+
+        std::vector<BoundingBox> color_bounding_boxes = color_pipeline::start_pipeline_colors(images.color_images, num_threads);
+        std::vector<BoundingBox> shape_bounding_boxes = gate_shapes
+            ? shape_pipeline::start_pipeline_gated_shapes(images.resized_images, color_bounding_boxes, num_threads)
+            : shape_pipeline::start_pipeline_shapes(images.shape_images, num_threads);
+        std::vector<BoundingBox> bounding_boxes = box_fusion_pipeline::start_pipeline_box_fusion(color_bounding_boxes, shape_bounding_boxes, images.resized_images,
+                                                                                                 !headless, image_writer.get());
+
+        if (result_writer) {
+            std::vector<std::vector<BoundingBox>> image_bounding_boxes(image_paths.size());
+            for (const auto& bounding_box : bounding_boxes) {
+                image_bounding_boxes[bounding_box.image_index].push_back(bounding_box);
+            }
+            for (size_t i = 0; i < image_paths.size(); i++) {
+                result_writer->write(image_paths[i], static_cast<int>(i), image_bounding_boxes[i]);
+            }
+        }
+    }
+
+    if (result_writer) {
+        result_writer->flush();
+    }
+
+    if (result_cache) {
+        ResultCache::Stats stats = result_cache->stats();
+        std::cout << "Result cache: " << stats.hits << " hits, " << stats.misses << " misses, " << stats.stores
+                  << " stored, " << stats.evictions << " evicted, " << stats.entries << " entries ("
+                  << stats.bytes / 1024 << " KiB)" << std::endl;
+    }
+
+    if (image_writer) {
+        image_writer->close();
+        std::cout << "Annotated images written: " << image_writer->written()
+                  << ", dropped: " << image_writer->dropped() << std::endl;
+    }
+
+    if (profiling::enabled()) {
+        profiling::print_summary(std::cout);
+        if (!trace_path.empty() && !profiling::write_chrome_trace(trace_path)) {
+            std::cerr << "Error: Unable to write trace to " << trace_path << std::endl;
+        }
+    } else if (!trace_path.empty()) {
+        std::cerr << "Warning: --trace needs a build with -DENABLE_PROFILING=ON" << std::endl;
+    }
+    return 0;
+
+}
 
+int main(int argc, char* argv[]) {
+    // Bad configs, packs, cache directories and arguments surface as exceptions; report them instead of aborting.
+    try {
+        return run(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
 }
@@ -4,33 +4,53 @@
 #include "../header/bounding_box.hpp"
 #include "../header/basic_image_operations.hpp"  // assuming similar utility
 #include "../header/pipeline_box_fusion.hpp"
+#include "../header/profiling.hpp"
 
 namespace box_fusion_pipeline {
-    std::vector<BoundingBox> start_pipeline_box_fusion(std::vector<BoundingBox> color_bounding_boxes, std::vector<BoundingBox> shape_bounding_boxes, std::vector<cv::Mat> resized_images) {
-         std::vector<BoundingBox> bounding_boxes = bounding_box::fuse_bounding_box_matches(
-            color_bounding_boxes, shape_bounding_boxes, 15
+    std::vector<BoundingBox> fuse_boxes(const std::vector<BoundingBox>& color_bounding_boxes, const std::vector<BoundingBox>& shape_bounding_boxes,
+                                        int match_deviation, int merge_deviation) {
+        PROFILE_SCOPE("fuse_boxes");
+        std::vector<BoundingBox> bounding_boxes = bounding_box::fuse_bounding_box_matches(
+            color_bounding_boxes, shape_bounding_boxes, match_deviation
         );
+        return bounding_box::merge_duplicate_boxes(bounding_boxes, merge_deviation);
+    }
 
-        bounding_boxes = bounding_box::merge_duplicate_boxes(bounding_boxes, 20);
+    std::vector<BoundingBox> start_pipeline_box_fusion(const std::vector<BoundingBox>& color_bounding_boxes, const std::vector<BoundingBox>& shape_bounding_boxes,
+                                                       ConstSpan<cv::Mat> resized_images, bool show_images,
+                                                       AnnotatedImageWriter* image_writer) {
+        std::vector<BoundingBox> bounding_boxes = fuse_boxes(color_bounding_boxes, shape_bounding_boxes);
 
         for (const auto& bounding_box : bounding_boxes) {
             //std::cout << bounding_box.to_string() << std::endl;
         }
 
-        std::vector<cv::Mat> bbox_images = resized_images;
-        for (auto& bounding_box : bounding_boxes) {
-            cv::Mat bbox_image = bounding_box::draw_bounding_box(bounding_box, bbox_images[bounding_box.image_index]);
-            bbox_images[bounding_box.image_index] = bbox_image;
-        }
-
         std::cout << "Bounding Boxes: " <<bounding_boxes.size() << std::endl;
         for (auto& bbox:bounding_boxes) {
             std::cout << bbox.to_string() << std::endl;
         }
         std::cout << "\n" << std::endl;
 
-        for (const auto& img : bbox_images) {
-            basic_ops::show_image(img, "traffic_sign_bboxes", false);
+        if (image_writer == nullptr && !show_images) return bounding_boxes;
+
+        std::vector<std::vector<BoundingBox>> image_bounding_boxes(resized_images.size());
+        for (const auto& bounding_box : bounding_boxes) {
+            image_bounding_boxes[bounding_box.image_index].push_back(bounding_box);
+        }
+
+        if (show_images) {
+            // Drawing goes onto copies, so resized_images stay valid for every other reader.
+            for (size_t i = 0; i < resized_images.size(); i++) {
+                basic_ops::show_image(bounding_box::draw_bounding_boxes(resized_images[i], image_bounding_boxes[i]),
+                                      "traffic_sign_bboxes", false);
+            }
+        }
+
+        // Detection is already finished here, so waiting for the writer costs nothing and no frame is dropped.
+        if (image_writer != nullptr) {
+            for (size_t i = 0; i < resized_images.size(); i++) {
+                image_writer->enqueue(resized_images[i], std::move(image_bounding_boxes[i]), "image_" + std::to_string(i) + ".jpg", true);
+            }
         }
         return bounding_boxes;
     }
@@ -1,3 +1,5 @@
+#include <array>
+#include <iterator>
 #include <vector>
 #include <iostream>
 #include <opencv2/opencv.hpp>
@@ -5,31 +7,61 @@
 #include "../header/color_detection.hpp"
 #include "../header/basic_image_operations.hpp"
 #include "../header/bounding_box.hpp"
+#include "../header/pipeline_colors.hpp"
+#include "../header/thread_pool.hpp"
+#include "../header/morphology.hpp"
+#include "../header/profiling.hpp"
+#include "../header/scratch_buffers.hpp"
 
 namespace color_pipeline {
-    std::vector<BoundingBox> start_pipeline_colors(std::vector<cv::Mat> color_images) {
-        std::vector<bool(*)(float, float, float)> color_functions = {
-            colors::is_strong_red,
-            colors::is_strong_yellow,
-            colors::is_strong_blue
-        };
+    std::vector<BoundingBox> detect_color_boxes(const cv::Mat& color_image, int image_index, double min_box_ratio,
+                                                int mask_opening) {
+        return detect_color_boxes(color_image, cv::Point(0, 0), color_image.size(), image_index, min_box_ratio, mask_opening);
+    }
+
+    std::vector<BoundingBox> detect_color_boxes(const cv::Mat& color_roi, const cv::Point& offset, const cv::Size& full_size,
+                                                int image_index, double min_box_ratio, int mask_opening) {
+        PROFILE_IMAGE_SCOPE("detect_color_boxes", image_index);
+        std::array<cv::Mat, 3> masks = {scratch::mat(scratch::COLOR_MASK_0, color_roi.size(), CV_8U),
+                                        scratch::mat(scratch::COLOR_MASK_1, color_roi.size(), CV_8U),
+                                        scratch::mat(scratch::COLOR_MASK_2, color_roi.size(), CV_8U)};
+        colors::get_masks<colors::StrongRed, colors::StrongYellow, colors::StrongBlue>(color_roi, masks);
+        std::array<cv::Vec3b, 3> box_colors =
+            colors::get_box_colors<colors::StrongRed, colors::StrongYellow, colors::StrongBlue>();
         std::vector<BoundingBox> color_bounding_boxes;
 
-        for (size_t i = 0; i < color_images.size(); i++) {
-            const cv::Mat& image = color_images[i];
-            int height = image.size().height;
-            int width = image.size().width;
-            int min_box_area = static_cast<int>((height * 0.055) * (height * 0.055));
-            int max_box_area = height * width;
-            for (auto color_function : color_functions) {
-                cv::Mat mask = colors::get_mask(image, color_function);
-                const std::vector<std::vector<cv::Point>>& blobs = cd::get_blobs(mask);
-                cv::Vec3b box_color = colors::get_color_from_function(color_function);
-                std::vector<BoundingBox> bounding_boxes = bounding_box::create_bounding_boxes(blobs, i, min_box_area, max_box_area, box_color);
-                for(auto bounding_box: bounding_boxes) {
-                    color_bounding_boxes.push_back(bounding_box);
+        int height = full_size.height;
+        int width = full_size.width;
+        int min_box_area = static_cast<int>((height * min_box_ratio) * (height * min_box_ratio));
+        int max_box_area = height * width;
+        std::vector<std::vector<cv::Point>>& blobs = scratch::vector<std::vector<cv::Point>>(scratch::COLOR_BLOBS);
+        for (size_t c = 0; c < masks.size(); c++) {
+            if (mask_opening > 1) masks[c] = morphology::opening(masks[c], mask_opening);
+            cd::get_blobs(masks[c], blobs);
+            if (offset != cv::Point(0, 0)) {
+                for (auto& blob : blobs) {
+                    for (auto& point : blob) point += offset;
                 }
             }
+            std::vector<BoundingBox> bounding_boxes = bounding_box::create_bounding_boxes(blobs, image_index, min_box_area, max_box_area, box_colors[c]);
+            color_bounding_boxes.insert(color_bounding_boxes.end(), std::make_move_iterator(bounding_boxes.begin()),
+                                        std::make_move_iterator(bounding_boxes.end()));
+        }
+        PROFILE_ITEMS(color_bounding_boxes.size());
+        return color_bounding_boxes;
+    }
+
+    std::vector<BoundingBox> start_pipeline_colors(ConstSpan<cv::Mat> color_images, size_t num_threads) {
+        std::vector<BoundingBox> color_bounding_boxes;
+
+        std::vector<std::vector<BoundingBox>> image_bounding_boxes(color_images.size());
+        ThreadPool pool(num_threads);
+        pool.parallel_for(color_images.size(), [&](size_t i) {
+            image_bounding_boxes[i] = detect_color_boxes(color_images[i], static_cast<int>(i));
+        });
+        for (auto& bounding_boxes : image_bounding_boxes) {
+            color_bounding_boxes.insert(color_bounding_boxes.end(), std::make_move_iterator(bounding_boxes.begin()),
+                                        std::make_move_iterator(bounding_boxes.end()));
         }
         color_bounding_boxes = bounding_box::merge_duplicate_boxes(color_bounding_boxes, 10);
 
@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <chrono>
+#include <set>
+#include <stdexcept>
+#include "../header/pipeline_graph.hpp"
+#include "../header/preprocessing_pipeline.hpp"
+#include "../header/pipeline_colors.hpp"
+#include "../header/pipeline_shapes.hpp"
+#include "../header/pipeline_box_fusion.hpp"
+#include "../header/morphology.hpp"
+#include "../header/profiling.hpp"
+
+namespace pipeline_graph {
+    namespace {
+        enum class ValueKind { Image, Boxes };
+
+        struct StageType {
+            std::vector<ValueKind> inputs;
+            ValueKind output;
+            std::set<std::string> params;
+            std::function<StageFunction(const pipeline_config::StageConfig&)> create;
+        };
+
+        const cv::Mat& image_input(const std::vector<const StageValue*>& inputs, size_t i) {
+            return std::get<cv::Mat>(*inputs[i]);
+        }
+
+        const std::vector<BoundingBox>& boxes_input(const std::vector<const StageValue*>& inputs, size_t i) {
+            return std::get<std::vector<BoundingBox>>(*inputs[i]);
+        }
+
+        // Parameters are checked when the graph is built, so a bad value is reported with the stage name instead of
+        // failing inside OpenCV (or dividing by zero) on a worker thread later.
+        int get_int_at_least(const pipeline_config::StageConfig& config, const std::string& key, int fallback, int minimum) {
+            int value = config.get_int(key, fallback);
+            if (value < minimum) {
+                throw std::runtime_error("Stage '" + config.name + "': " + key + " must be at least " + std::to_string(minimum) +
+                                         ", got " + std::to_string(value));
+            }
+            return value;
+        }
+
+        int get_odd_size(const pipeline_config::StageConfig& config, const std::string& key, int fallback) {
+            int value = get_int_at_least(config, key, fallback, 1);
+            if (value % 2 == 0) {
+                throw std::runtime_error("Stage '" + config.name + "': " + key + " must be odd, got " + std::to_string(value));
+            }
+            return value;
+        }
+
+        double get_double_at_least(const pipeline_config::StageConfig& config, const std::string& key, double fallback, double minimum) {
+            double value = config.get_double(key, fallback);
+            if (!(value >= minimum)) {
+                throw std::runtime_error("Stage '" + config.name + "': " + key + " must be at least " + std::to_string(minimum) +
+                                         ", got " + std::to_string(value));
+            }
+            return value;
+        }
+
+        const std::map<std::string, StageType>& stage_registry() {
+            static const std::map<std::string, StageType> registry = {
+                {"resize", {{ValueKind::Image}, ValueKind::Image, {"factor"},
+                    [](const pipeline_config::StageConfig& config) -> StageFunction {
+                        int factor = get_int_at_least(config, "factor", 8, 1);
+                        return [factor](const std::vector<const StageValue*>& inputs, int) -> StageValue {
+                            return pipeline_preprocessing::preprocess_resizing(image_input(inputs, 0), factor);
+                        };
+                    }}},
+                {"median_blur", {{ValueKind::Image}, ValueKind::Image, {"kernel_size"},
+                    [](const pipeline_config::StageConfig& config) -> StageFunction {
+                        int kernel_size = get_odd_size(config, "kernel_size", 5);
+                        return [kernel_size](const std::vector<const StageValue*>& inputs, int) -> StageValue {
+                            return pipeline_preprocessing::preprocess_colors(image_input(inputs, 0), kernel_size);
+                        };
+                    }}},
+                {"edges", {{ValueKind::Image}, ValueKind::Image, {"blur_size", "threshold"},
+                    [](const pipeline_config::StageConfig& config) -> StageFunction {
+                        int blur_size = get_int_at_least(config, "blur_size", 5, 1);
+                        int threshold = config.get_int("threshold", 30);
+                        return [blur_size, threshold](const std::vector<const StageValue*>& inputs, int) -> StageValue {
+                            return pipeline_preprocessing::preprocess_shapes(image_input(inputs, 0), blur_size, threshold);
+                        };
+                    }}},
+                {"morphology", {{ValueKind::Image}, ValueKind::Image, {"operation", "kernel_size"},
+                    [](const pipeline_config::StageConfig& config) -> StageFunction {
+                        static const std::map<std::string, cv::Mat (*)(const cv::Mat&, int)> operations = {
+                            {"erode", morphology::erode}, {"dilate", morphology::dilate},
+                            {"open", morphology::opening}, {"close", morphology::closing},
+                            {"gradient", morphology::gradient}, {"top_hat", morphology::top_hat},
+                        };
+                        std::string operation = config.get_string("operation", "open");
+                        auto operation_it = operations.find(operation);
+                        if (operation_it == operations.end()) {
+                            throw std::runtime_error("Stage '" + config.name + "': unknown operation '" + operation +
+                                                     "' (erode, dilate, open, close, gradient, top_hat)");
+                        }
+                        int kernel_size = get_int_at_least(config, "kernel_size", 3, 1);
+                        auto apply = operation_it->second;
+                        return [apply, kernel_size](const std::vector<const StageValue*>& inputs, int) -> StageValue {
+                            return apply(image_input(inputs, 0), kernel_size);
+                        };
+                    }}},
+                {"color_boxes", {{ValueKind::Image}, ValueKind::Boxes, {"min_box_ratio", "merge_deviation", "mask_opening"},
+                    [](const pipeline_config::StageConfig& config) -> StageFunction {
+                        double min_box_ratio = get_double_at_least(config, "min_box_ratio", 0.055, 0.0);
+                        int merge_deviation = get_int_at_least(config, "merge_deviation", 10, 0);
+                        int mask_opening = get_int_at_least(config, "mask_opening", 0, 0);
+                        return [min_box_ratio, merge_deviation, mask_opening](const std::vector<const StageValue*>& inputs, int image_index) -> StageValue {
+                            return bounding_box::merge_duplicate_boxes(
+                                color_pipeline::detect_color_boxes(image_input(inputs, 0), image_index, min_box_ratio, mask_opening),
+                                merge_deviation);
+                        };
+                    }}},
+                {"shape_boxes", {{ValueKind::Image}, ValueKind::Boxes, {"min_box_ratio", "merge_deviation"},
+                    [](const pipeline_config::StageConfig& config) -> StageFunction {
+                        double min_box_ratio = get_double_at_least(config, "min_box_ratio", 0.055, 0.0);
+                        int merge_deviation = get_int_at_least(config, "merge_deviation", 10, 0);
+                        return [min_box_ratio, merge_deviation](const std::vector<const StageValue*>& inputs, int image_index) -> StageValue {
+                            return bounding_box::merge_duplicate_boxes(
+                                shape_pipeline::detect_shape_boxes(image_input(inputs, 0), image_index, min_box_ratio), merge_deviation);
+                        };
+                    }}},
+                {"gated_shape_boxes", {{ValueKind::Image, ValueKind::Boxes}, ValueKind::Boxes,
+                                       {"padding", "blur_size", "threshold", "min_box_ratio", "merge_deviation"},
+                    [](const pipeline_config::StageConfig& config) -> StageFunction {
+                        float padding = static_cast<float>(get_double_at_least(config, "padding", 0.5, 0.0));
+                        int blur_size = get_int_at_least(config, "blur_size", 5, 1);
+                        int threshold = config.get_int("threshold", 30);
+                        double min_box_ratio = get_double_at_least(config, "min_box_ratio", 0.055, 0.0);
+                        int merge_deviation = get_int_at_least(config, "merge_deviation", 10, 0);
+                        return [=](const std::vector<const StageValue*>& inputs, int image_index) -> StageValue {
+                            return bounding_box::merge_duplicate_boxes(
+                                shape_pipeline::detect_gated_shape_boxes(image_input(inputs, 0), boxes_input(inputs, 1), image_index,
+                                                                         padding, blur_size, threshold, min_box_ratio),
+                                merge_deviation);
+                        };
+                    }}},
+                {"fuse", {{ValueKind::Boxes, ValueKind::Boxes}, ValueKind::Boxes, {"match_deviation", "merge_deviation"},
+                    [](const pipeline_config::StageConfig& config) -> StageFunction {
+                        int match_deviation = get_int_at_least(config, "match_deviation", 15, 0);
+                        int merge_deviation = get_int_at_least(config, "merge_deviation", 20, 0);
+                        return [match_deviation, merge_deviation](const std::vector<const StageValue*>& inputs, int) -> StageValue {
+                            return box_fusion_pipeline::fuse_boxes(boxes_input(inputs, 0), boxes_input(inputs, 1),
+                                                                   match_deviation, merge_deviation);
+                        };
+                    }}},
+            };
+            return registry;
+        }
+    }
+
+    std::vector<std::string> stage_types() {
+        std::vector<std::string> types;
+        for (const auto& entry : stage_registry()) {
+            types.push_back(entry.first);
+        }
+        return types;
+    }
+
+    PipelineGraph::PipelineGraph(const pipeline_config::PipelineConfig& config, ThreadPool* pool) : pool(pool) {
+        const auto& registry = stage_registry();
+
+        std::map<std::string, size_t> config_index;
+        for (size_t i = 0; i < config.stages.size(); ++i) {
+            config_index[config.stages[i].name] = i;
+        }
+
+        // Depth-first topological sort; stage slots are assigned in dependency order.
+        std::map<std::string, size_t> slot_of = {{"source", 0}};
+        std::map<std::string, ValueKind> kind_of = {{"source", ValueKind::Image}};
+        std::vector<size_t> level_of = {0};
+        std::set<std::string> visiting;
+
+        std::function<void(const std::string&)> visit = [&](const std::string& name) {
+            if (slot_of.count(name)) return;
+            auto config_it = config_index.find(name);
+            if (config_it == config_index.end()) {
+                throw std::runtime_error("Unknown stage '" + name + "'");
+            }
+            if (!visiting.insert(name).second) {
+                throw std::runtime_error("Pipeline stages form a cycle at '" + name + "'");
+            }
+
+            const pipeline_config::StageConfig& stage_config = config.stages[config_it->second];
+            auto type_it = registry.find(stage_config.type);
+            if (type_it == registry.end()) {
+                throw std::runtime_error("Stage '" + name + "' has unknown type '" + stage_config.type + "'");
+            }
+            const StageType& type = type_it->second;
+            if (stage_config.inputs.size() != type.inputs.size()) {
+                throw std::runtime_error("Stage '" + name + "' (" + stage_config.type + ") expects "
+                                         + std::to_string(type.inputs.size()) + " input(s)");
+            }
+            for (const auto& param : stage_config.params) {
+                if (!type.params.count(param.first)) {
+                    throw std::runtime_error("Stage '" + name + "' has unknown parameter '" + param.first + "'");
+                }
+            }
+
+            Stage stage;
+            stage.name = name;
+            stage.profile_name = profiling::intern("stage:" + name);
+            size_t level = 0;
+            for (size_t i = 0; i < stage_config.inputs.size(); ++i) {
+                const std::string& input = stage_config.inputs[i];
+                visit(input);
+                if (kind_of[input] != type.inputs[i]) {
+                    throw std::runtime_error("Stage '" + name + "': input '" + input + "' has the wrong kind");
+                }
+                stage.inputs.push_back(slot_of[input]);
+                level = std::max(level, level_of[slot_of[input]] + 1);
+            }
+            stage.function = type.create(stage_config);
+
+            visiting.erase(name);
+            stages.push_back(std::move(stage));
+            slot_of[name] = stages.size();
+            kind_of[name] = type.output;
+            level_of.push_back(level);
+            if (levels.size() < level) levels.resize(level);
+            levels[level - 1].push_back(stages.size() - 1);
+        };
+
+        if (config.output_stage.empty()) {
+            throw std::runtime_error("Pipeline has no output stage");
+        }
+        visit(config.output_stage);
+        if (kind_of[config.output_stage] != ValueKind::Boxes) {
+            throw std::runtime_error("Output stage '" + config.output_stage + "' does not produce bounding boxes");
+        }
+        output_index = slot_of[config.output_stage];
+
+        if (!config.annotation_stage.empty()) {
+            visit(config.annotation_stage);
+            if (kind_of[config.annotation_stage] != ValueKind::Image) {
+                throw std::runtime_error("Annotation stage '" + config.annotation_stage + "' does not produce an image");
+            }
+            annotation_index = slot_of[config.annotation_stage];
+            has_annotation = true;
+        }
+    }
+
+    std::vector<StageValue> PipelineGraph::execute(const cv::Mat& source_image, int image_index, std::vector<double>* stage_ms) const {
+        std::vector<StageValue> values(stages.size() + 1);
+        values[0] = source_image;
+        if (stage_ms != nullptr) stage_ms->assign(stages.size(), 0.0);
+
+        auto run_stage = [&](size_t stage_index) {
+            const Stage& stage = stages[stage_index];
+            PROFILE_IMAGE_SCOPE(stage.profile_name, image_index);
+            std::vector<const StageValue*> inputs;
+            for (size_t input : stage.inputs) {
+                inputs.push_back(&values[input]);
+            }
+            auto start = std::chrono::steady_clock::now();
+            values[stage_index + 1] = stage.function(inputs, image_index);
+            if (stage_ms != nullptr) {
+                (*stage_ms)[stage_index] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+        };
+
+        for (const auto& level : levels) {
+            if (pool != nullptr && level.size() > 1) {
+                pool->parallel_for(level.size(), [&](size_t i) { run_stage(level[i]); });
+            } else {
+                for (size_t stage_index : level) {
+                    run_stage(stage_index);
+                }
+            }
+        }
+        return values;
+    }
+
+    GraphResult PipelineGraph::run(const cv::Mat& source_image, int image_index, bool with_stage_boxes,
+                                   std::vector<double>* stage_ms) const {
+        std::vector<StageValue> values = execute(source_image, image_index, stage_ms);
+        GraphResult result;
+        result.bounding_boxes = std::get<std::vector<BoundingBox>>(values[output_index]);
+        if (has_annotation) {
+            result.annotation_image = std::get<cv::Mat>(values[annotation_index]);
+        }
+        if (with_stage_boxes) {
+            for (size_t i = 0; i < stages.size(); ++i) {
+                if (auto* boxes = std::get_if<std::vector<BoundingBox>>(&values[i + 1])) {
+                    result.stage_boxes[stages[i].name] = std::move(*boxes);
+                }
+            }
+        }
+        return result;
+    }
+
+    std::map<std::string, StageValue> PipelineGraph::run_stages(const cv::Mat& source_image, int image_index) const {
+        std::vector<StageValue> values = execute(source_image, image_index);
+        std::map<std::string, StageValue> results;
+        for (size_t i = 0; i < stages.size(); ++i) {
+            results[stages[i].name] = values[i + 1];
+        }
+        return results;
+    }
+
+    std::vector<std::string> PipelineGraph::stage_names() const {
+        std::vector<std::string> names;
+        for (const auto& stage : stages) {
+            names.push_back(stage.name);
+        }
+        return names;
+    }
+}
@@ -1,28 +1,62 @@
 #include <opencv2/opencv.hpp>
+#include <iterator>
 #include <vector>
+#include <iostream>
 #include "../header/bounding_box.hpp"
+#include "../header/pipeline_shapes.hpp"
+#include "../header/thread_pool.hpp"
+#include "../header/profiling.hpp"
 #include "../header/shape_detection.hpp"
 #include "../header/basic_image_operations.hpp"
+#include "../header/preprocessing_pipeline.hpp"
 
 namespace shape_pipeline {
-    std::vector<BoundingBox> start_pipeline_shapes(std::vector<cv::Mat> shape_images) {
+    std::vector<BoundingBox> detect_shape_boxes(const cv::Mat& shape_image, int image_index, double min_box_ratio) {
+        return detect_shape_boxes(shape_image, cv::Point(0, 0), shape_image.size(), image_index, min_box_ratio);
+    }
 
-        std::vector<BoundingBox> shape_bounding_boxes;
+    std::vector<BoundingBox> detect_shape_boxes(const cv::Mat& shape_roi, const cv::Point& offset, const cv::Size& full_size,
+                                                int image_index, double min_box_ratio) {
+        PROFILE_IMAGE_SCOPE("detect_shape_boxes", image_index);
+        //std::vector<std::vector<cv::Point>> contours = sd::get_contours(shape_image, 15);
+        std::vector<std::vector<cv::Point> > contours;
+        {
+            PROFILE_SCOPE("findContours");
+            findContours(shape_roi, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE, offset);
+            PROFILE_ITEMS(contours.size());
+        }
+        int height = full_size.height;
+        int width = full_size.width;
+        cv::Vec3b box_color = {255, 255, 255};
 
-        for (size_t i = 0; i < shape_images.size(); i++) {
-            const cv::Mat& image = shape_images[i];
-            //std::vector<std::vector<cv::Point>> contours = sd::get_contours(image, 15);
-            std::vector<std::vector<cv::Point> > contours;
-            findContours(image, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
-            int height = image.rows;
-            int width = image.cols;
-            cv::Vec3b box_color = {255, 255, 255};
+        int min_box_area = static_cast<int>(pow(height * min_box_ratio, 2));
+        int max_box_area = height * width;
+
+        return bounding_box::create_bounding_boxes(contours, image_index, min_box_area, max_box_area, box_color);
+    }
 
-            int min_box_area = static_cast<int>(pow(height * 0.055, 2));
-            int max_box_area = height * width;
+    std::vector<BoundingBox> detect_gated_shape_boxes(const cv::Mat& resized_image, const std::vector<BoundingBox>& color_candidates,
+                                                      int image_index, float padding, int blur_size,
+                                                      int edge_threshold, double min_box_ratio) {
+        PROFILE_IMAGE_SCOPE("detect_gated_shape_boxes", image_index);
+        std::vector<cv::Rect> regions = bounding_box::padded_box_regions(color_candidates, resized_image.size(), padding);
+        PROFILE_ITEMS(regions.size());
 
-            std::vector<BoundingBox> bounding_boxes = bounding_box::create_bounding_boxes(contours, i, min_box_area, max_box_area, box_color);
-            shape_bounding_boxes.insert(shape_bounding_boxes.end(), bounding_boxes.begin(), bounding_boxes.end());
+        std::vector<BoundingBox> shape_bounding_boxes;
+        for (const cv::Rect& region : regions) {
+            cv::Mat shape_roi = pipeline_preprocessing::preprocess_shapes(resized_image(region), blur_size, edge_threshold);
+            std::vector<BoundingBox> region_boxes = detect_shape_boxes(shape_roi, region.tl(), resized_image.size(), image_index, min_box_ratio);
+            shape_bounding_boxes.insert(shape_bounding_boxes.end(), std::make_move_iterator(region_boxes.begin()),
+                                        std::make_move_iterator(region_boxes.end()));
+        }
+        return shape_bounding_boxes;
+    }
+
+    std::vector<BoundingBox> collect_shape_boxes(std::vector<std::vector<BoundingBox>>& image_bounding_boxes) {
+        std::vector<BoundingBox> shape_bounding_boxes;
+        for (auto& bounding_boxes : image_bounding_boxes) {
+            shape_bounding_boxes.insert(shape_bounding_boxes.end(), std::make_move_iterator(bounding_boxes.begin()),
+                                        std::make_move_iterator(bounding_boxes.end()));
         }
 
         shape_bounding_boxes = bounding_box::merge_duplicate_boxes(shape_bounding_boxes, 10);
@@ -35,4 +69,28 @@ namespace shape_pipeline {
 
         return shape_bounding_boxes;
     }
+
+    std::vector<BoundingBox> start_pipeline_shapes(ConstSpan<cv::Mat> shape_images, size_t num_threads) {
+        std::vector<std::vector<BoundingBox>> image_bounding_boxes(shape_images.size());
+        ThreadPool pool(num_threads);
+        pool.parallel_for(shape_images.size(), [&](size_t i) {
+            image_bounding_boxes[i] = detect_shape_boxes(shape_images[i], static_cast<int>(i));
+        });
+        return collect_shape_boxes(image_bounding_boxes);
+    }
+
+    std::vector<BoundingBox> start_pipeline_gated_shapes(ConstSpan<cv::Mat> resized_images,
+                                                         const std::vector<BoundingBox>& color_bounding_boxes, size_t num_threads) {
+        std::vector<std::vector<BoundingBox>> color_candidates(resized_images.size());
+        for (const auto& bounding_box : color_bounding_boxes) {
+            color_candidates[bounding_box.image_index].push_back(bounding_box);
+        }
+
+        std::vector<std::vector<BoundingBox>> image_bounding_boxes(resized_images.size());
+        ThreadPool pool(num_threads);
+        pool.parallel_for(resized_images.size(), [&](size_t i) {
+            image_bounding_boxes[i] = detect_gated_shape_boxes(resized_images[i], color_candidates[i], static_cast<int>(i));
+        });
+        return collect_shape_boxes(image_bounding_boxes);
+    }
 }
\ No newline at end of file
@@ -1,74 +1,124 @@
 #include <opencv2/opencv.hpp>
 #include <opencv2/imgproc.hpp>
 #include <vector>
+#include <stdexcept>
 #include <string>
 #include <filesystem>
 #include "../header/basic_image_operations.hpp"
 #include "../header/geometrical_image_operations.hpp"
+#include "../header/image_loader.hpp"
+#include "../header/preprocessing_pipeline.hpp"
+#include "../header/profiling.hpp"
+#include "../header/scratch_buffers.hpp"
 
 namespace pipeline_preprocessing {
-    std::vector<cv::Mat> preprocess_resizing(const std::vector<cv::Mat>& images) {
-        std::vector<cv::Mat> resized_images;
-        for (const auto& image : images) {
-            int height = image.size().height;
-            int width = image.size().width;
-            cv::Mat resized_image = geo_ops::resize_image(image, static_cast<int>(width/8), static_cast<int>(height/8));
+    cv::Mat preprocess_resizing(const cv::Mat& image, int resize_factor) {
+        PROFILE_SCOPE("preprocess_resizing");
+        int height = image.size().height;
+        int width = image.size().width;
+        return geo_ops::resize_image(image, static_cast<int>(width/resize_factor), static_cast<int>(height/resize_factor));
+    }
+
+    cv::Mat load_resized_image(const std::string& image_path, int resize_factor, bool print) {
+        return basic_ops::load_image_scaled(image_path, resize_factor, print);
+    }
+
+    cv::Mat preprocess_colors(const cv::Mat& image, int median_kernel_size) {
+        PROFILE_SCOPE("preprocess_colors");
+        cv::Mat color_image;
+        cv::medianBlur(image, color_image, median_kernel_size);
+        return color_image;
+    }
+
+    cv::Mat preprocess_shapes(const cv::Mat& image, int blur_size, int edge_threshold) {
+        PROFILE_SCOPE("preprocess_shapes");
+        // Only the final edge image is allocated; the intermediates live in per-thread scratch buffers.
+        cv::Mat gray = scratch::mat(scratch::SHAPE_GRAY, image.size(), CV_8U);
+        cv::cvtColor(image, gray, cv::COLOR_BGR2GRAY);
+        cv::blur(gray, gray, cv::Size(blur_size, blur_size));
+
+        cv::Mat sobelX = scratch::mat(scratch::SOBEL_X, image.size(), CV_64F);
+        cv::Mat sobelY = scratch::mat(scratch::SOBEL_Y, image.size(), CV_64F);
+        cv::Mat sobelMag = scratch::mat(scratch::SOBEL_MAGNITUDE, image.size(), CV_64F);
+        cv::Sobel(gray, sobelX, CV_64F, 1, 0, 3);
+        cv::Sobel(gray, sobelY, CV_64F, 0, 1, 3);
+        cv::magnitude(sobelX, sobelY, sobelMag);
+
+        cv::Mat shape_image;
+        sobelMag.convertTo(shape_image, CV_8U);
+
+        cv::threshold(shape_image, shape_image, edge_threshold, 255, cv::THRESH_BINARY);
+        return shape_image;
+    }
 
-            resized_images.push_back(resized_image);
+    std::vector<cv::Mat> preprocess_resizing(ConstSpan<cv::Mat> images) {
+        std::vector<cv::Mat> resized_images;
+        resized_images.reserve(images.size());
+        for (size_t i = 0; i < images.size(); i++) {
+            PROFILE_IMAGE_SCOPE("preprocess_image", static_cast<int>(i));
+            resized_images.push_back(preprocess_resizing(images[i]));
         }
         return resized_images;
     }
 
-    std::vector<cv::Mat> preprocess_colors(const std::vector<cv::Mat>& images) {
+    std::vector<cv::Mat> preprocess_colors(ConstSpan<cv::Mat> images) {
         std::vector<cv::Mat> color_images;
-        for (const auto& image : images) {
-            cv::Mat color_image;
-            cv::medianBlur(image, color_image, 5);
-            color_images.push_back(color_image);
+        color_images.reserve(images.size());
+        for (size_t i = 0; i < images.size(); i++) {
+            PROFILE_IMAGE_SCOPE("preprocess_image", static_cast<int>(i));
+            color_images.push_back(preprocess_colors(images[i]));
         }
         return color_images;
     }
 
-    std::vector<cv::Mat> preprocess_shapes(const std::vector<cv::Mat>& images) {
+    std::vector<cv::Mat> preprocess_shapes(ConstSpan<cv::Mat> images) {
         std::vector<cv::Mat> shape_images;
-        for (auto& image : images) {
-            cv::Mat shape_image;
-            cv::cvtColor(image, shape_image, cv::COLOR_BGR2GRAY);
-            cv::blur(shape_image, shape_image, cv::Size(5, 5));
-
-            cv::Mat sobelX, sobelY, sobelMag;
-            cv::Sobel(shape_image, sobelX, CV_64F, 1, 0, 3);
-            cv::Sobel(shape_image, sobelY, CV_64F, 0, 1, 3);
-            cv::magnitude(sobelX, sobelY, shape_image);
-            shape_image.convertTo(shape_image, CV_8U);
-
-            cv::threshold(shape_image, shape_image, 30, 255, cv::THRESH_BINARY);
-            shape_images.push_back(shape_image);
+        shape_images.reserve(images.size());
+        for (size_t i = 0; i < images.size(); i++) {
+            PROFILE_IMAGE_SCOPE("preprocess_image", static_cast<int>(i));
+            shape_images.push_back(preprocess_shapes(images[i]));
         }
         return shape_images;
     }
 
-    std::vector<std::vector<cv::Mat>> start_preprocessing_pipeline() {
-
-        std::vector<std::string> folders = {
+    std::vector<std::string> get_image_folders() {
+        return {
             "../traffic_sign_images/vf",
             //"../traffic_sign_images/vfa",
            // "../traffic_sign_images/vfs",
             //"../traffic_sign_images/stop"
-
         };
+    }
 
-        std::vector<cv::Mat> original_images;
+    const std::vector<std::string>& get_dataset_labels() {
+        static const std::vector<std::string> labels = {"vf", "vfa", "vfs", "stop", "false"};
+        return labels;
+    }
+
+    std::vector<std::string> get_image_paths() {
+        return get_image_paths(get_image_folders(), 100);
+    }
+
+    std::vector<std::string> get_image_paths(const std::vector<std::string>& folders, int max_images_per_folder) {
+        std::vector<std::string> image_paths;
         for (const auto& folder : folders) {
-            std::vector<cv::Mat> images = basic_ops::load_images(folder, 100, true);
-            for (auto& image : images) {
-                original_images.push_back(image);
-            }
+            std::vector<std::string> folder_paths = basic_ops::list_image_paths(folder, max_images_per_folder);
+            image_paths.insert(image_paths.end(), folder_paths.begin(), folder_paths.end());
         }
+        return image_paths;
+    }
 
-        std::vector<cv::Mat> resized_images = preprocess_resizing(original_images);
-        std::vector<cv::Mat> color_images = preprocess_colors(resized_images);
-        std::vector<cv::Mat> shape_images = preprocess_shapes(resized_images);
+    PreprocessedImages start_preprocessing_pipeline(std::vector<std::string>* image_paths, bool with_shape_images) {
+
+        PreprocessedImages images;
+        ImageLoader loader(get_image_paths(), 0, 16, [](const std::string& image_path) { return load_resized_image(image_path); });
+        while (std::optional<ImageLoader::LoadedImage> loaded = loader.next()) {
+            images.resized_images.push_back(std::move(loaded->image));
+            if (image_paths != nullptr) image_paths->push_back(loaded->source_path);
+        }
+
+        images.color_images = preprocess_colors(images.resized_images);
+        if (with_shape_images) images.shape_images = preprocess_shapes(images.resized_images);
 
 
         /*std::vector<cv::Mat> stop_templates = basic_ops::load_images("../traffic_sign_templates/stop_signs/resized", 100, false);
@@ -86,7 +136,35 @@ namespace pipeline_preprocessing {
         std::vector<cv::Mat> colors_template_images = preprocess_colors(base_templates);
         std::vector<cv::Mat> shape_template_images = preprocess_shapes(base_templates);*/
 
-        std::vector<std::vector<cv::Mat>> images = {resized_images, color_images, shape_images};
+        return images;
+    }
+
+    PreprocessedImages start_preprocessing_pipeline(const packed_dataset::PackedDataset& dataset,
+                                                    std::vector<std::string>* image_paths, bool with_shape_images) {
+        if (dataset.resize_factor() != RESIZE_FACTOR) {
+            throw std::runtime_error("Packed dataset was built with --resize " + std::to_string(dataset.resize_factor()) +
+                                     ", the pipeline needs " + std::to_string(RESIZE_FACTOR));
+        }
+        PreprocessedImages images;
+        images.resized_images.reserve(dataset.size());
+        for (size_t i = 0; i < dataset.size(); i++) {
+            images.resized_images.push_back(dataset.frame(i, packed_dataset::RESIZED));
+            if (image_paths != nullptr) image_paths->push_back(dataset.source_path(i));
+        }
+
+        if (dataset.has_frames(packed_dataset::COLOR)) {
+            images.color_images.reserve(dataset.size());
+            for (size_t i = 0; i < dataset.size(); i++) images.color_images.push_back(dataset.frame(i, packed_dataset::COLOR));
+        } else {
+            images.color_images = preprocess_colors(images.resized_images);
+        }
+
+        if (with_shape_images && dataset.has_frames(packed_dataset::SHAPE)) {
+            images.shape_images.reserve(dataset.size());
+            for (size_t i = 0; i < dataset.size(); i++) images.shape_images.push_back(dataset.frame(i, packed_dataset::SHAPE));
+        } else if (with_shape_images) {
+            images.shape_images = preprocess_shapes(images.resized_images);
+        }
         return images;
     }
 }
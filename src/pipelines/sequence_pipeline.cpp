@@ -0,0 +1,72 @@
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include "../header/sequence_pipeline.hpp"
+#include "../header/box_tracker.hpp"
+#include "../header/image_loader.hpp"
+#include "../header/preprocessing_pipeline.hpp"
+#include "../header/pipeline_colors.hpp"
+#include "../header/pipeline_shapes.hpp"
+#include "../header/pipeline_box_fusion.hpp"
+#include "../header/profiling.hpp"
+
+namespace sequence_pipeline {
+    std::vector<BoundingBox> detect_full_frame(const cv::Mat& resized_image, int image_index) {
+        PROFILE_IMAGE_SCOPE("detect_full_frame", image_index);
+        cv::Mat color_image = pipeline_preprocessing::preprocess_colors(resized_image);
+        cv::Mat shape_image = pipeline_preprocessing::preprocess_shapes(resized_image);
+        std::vector<BoundingBox> color_bounding_boxes = bounding_box::merge_duplicate_boxes(
+            color_pipeline::detect_color_boxes(color_image, image_index), 10);
+        std::vector<BoundingBox> shape_bounding_boxes = bounding_box::merge_duplicate_boxes(
+            shape_pipeline::detect_shape_boxes(shape_image, image_index), 10);
+        return box_fusion_pipeline::fuse_boxes(color_bounding_boxes, shape_bounding_boxes);
+    }
+
+    std::vector<BoundingBox> detect_regions(const cv::Mat& resized_image, const std::vector<cv::Rect>& regions, int image_index) {
+        PROFILE_IMAGE_SCOPE("detect_regions", image_index);
+        PROFILE_ITEMS(regions.size());
+        std::vector<BoundingBox> color_bounding_boxes;
+        std::vector<BoundingBox> shape_bounding_boxes;
+        for (const cv::Rect& region : regions) {
+            cv::Mat roi = resized_image(region);
+            std::vector<BoundingBox> region_color_boxes = color_pipeline::detect_color_boxes(
+                pipeline_preprocessing::preprocess_colors(roi), region.tl(), resized_image.size(), image_index);
+            std::vector<BoundingBox> region_shape_boxes = shape_pipeline::detect_shape_boxes(
+                pipeline_preprocessing::preprocess_shapes(roi), region.tl(), resized_image.size(), image_index);
+            color_bounding_boxes.insert(color_bounding_boxes.end(), region_color_boxes.begin(), region_color_boxes.end());
+            shape_bounding_boxes.insert(shape_bounding_boxes.end(), region_shape_boxes.begin(), region_shape_boxes.end());
+        }
+        color_bounding_boxes = bounding_box::merge_duplicate_boxes(color_bounding_boxes, 10);
+        shape_bounding_boxes = bounding_box::merge_duplicate_boxes(shape_bounding_boxes, 10);
+        return box_fusion_pipeline::fuse_boxes(color_bounding_boxes, shape_bounding_boxes);
+    }
+
+    void start_sequence_pipeline(const std::vector<std::string>& image_paths, const SequenceOptions& options,
+                                 const std::function<void(const streaming_pipeline::ImageResult&)>& on_result) {
+        // Only decoding and resizing happen ahead of time; the remaining preprocessing depends on the regions.
+        ImageLoader loader(image_paths, 0, options.window_size,
+                           [](const std::string& image_path) { return pipeline_preprocessing::load_resized_image(image_path); });
+
+        BoxTracker tracker(options.max_misses);
+        int frames_since_scan = 0;
+        int image_index = 0;
+        while (std::optional<ImageLoader::LoadedImage> frame = loader.next()) {
+            bool full_scan = tracker.empty() || options.rescan_interval <= 1 || frames_since_scan + 1 >= options.rescan_interval;
+
+            streaming_pipeline::ImageResult result;
+            result.image_index = image_index++;
+            result.source_path = frame->source_path;
+            result.resized_image = frame->image;
+            if (full_scan) {
+                result.bounding_boxes = detect_full_frame(frame->image, result.image_index);
+                frames_since_scan = 0;
+            } else {
+                std::vector<cv::Rect> regions = tracker.predicted_regions(frame->image.size(), options.roi_padding);
+                result.bounding_boxes = detect_regions(frame->image, regions, result.image_index);
+                frames_since_scan++;
+            }
+
+            tracker.update(result.bounding_boxes);
+            on_result(result);
+        }
+    }
+}
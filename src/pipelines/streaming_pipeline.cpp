@@ -0,0 +1,69 @@
+#include <opencv2/opencv.hpp>
+#include <thread>
+#include <vector>
+#include "../header/streaming_pipeline.hpp"
+#include "../header/bounded_queue.hpp"
+#include "../header/image_loader.hpp"
+#include "../header/preprocessing_pipeline.hpp"
+#include "../header/pipeline_colors.hpp"
+#include "../header/pipeline_shapes.hpp"
+#include "../header/pipeline_box_fusion.hpp"
+#include "../header/profiling.hpp"
+
+namespace streaming_pipeline {
+    struct PreprocessedFrame {
+        int image_index;
+        std::string source_path;
+        cv::Mat resized_image;
+        cv::Mat color_image;
+        cv::Mat shape_image;
+    };
+
+    void start_streaming_pipeline(const std::vector<std::string>& image_paths, size_t window_size,
+                                  const std::function<void(const ImageResult&)>& on_result, bool gate_shapes) {
+        BoundedQueue<PreprocessedFrame> frames(window_size);
+
+        // Files are decoded in parallel ahead of the preprocessing thread, which in turn runs ahead of detection.
+        ImageLoader image_loader(image_paths, 0, window_size,
+                                 [](const std::string& image_path) { return pipeline_preprocessing::load_resized_image(image_path); });
+
+        std::thread loader([&]() {
+            int image_index = 0;
+            while (std::optional<ImageLoader::LoadedImage> loaded = image_loader.next()) {
+                PROFILE_IMAGE_SCOPE("preprocess_frame", image_index);
+                PreprocessedFrame frame;
+                frame.image_index = image_index++;
+                frame.source_path = loaded->source_path;
+                frame.resized_image = std::move(loaded->image);
+                frame.color_image = pipeline_preprocessing::preprocess_colors(frame.resized_image);
+                if (!gate_shapes) frame.shape_image = pipeline_preprocessing::preprocess_shapes(frame.resized_image);
+                if (!frames.push(std::move(frame))) break;
+            }
+            frames.close();
+        });
+
+        // If detection or on_result throws, stop the loader before unwinding: a joinable std::thread would terminate.
+        try {
+            while (std::optional<PreprocessedFrame> frame = frames.pop()) {
+                PROFILE_IMAGE_SCOPE("detect_image", frame->image_index);
+                std::vector<BoundingBox> color_bounding_boxes = bounding_box::merge_duplicate_boxes(
+                    color_pipeline::detect_color_boxes(frame->color_image, frame->image_index), 10);
+                std::vector<BoundingBox> shape_bounding_boxes = bounding_box::merge_duplicate_boxes(
+                    gate_shapes ? shape_pipeline::detect_gated_shape_boxes(frame->resized_image, color_bounding_boxes, frame->image_index)
+                                : shape_pipeline::detect_shape_boxes(frame->shape_image, frame->image_index), 10);
+
+                ImageResult result;
+                result.image_index = frame->image_index;
+                result.source_path = frame->source_path;
+                result.resized_image = frame->resized_image;
+                result.bounding_boxes = box_fusion_pipeline::fuse_boxes(color_bounding_boxes, shape_bounding_boxes);
+                on_result(result);
+            }
+        } catch (...) {
+            frames.close();
+            loader.join();
+            throw;
+        }
+        loader.join();
+    }
+}
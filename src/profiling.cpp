@@ -0,0 +1,179 @@
+#include "header/profiling.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+namespace profiling {
+    namespace {
+        struct Event {
+            const char* name;
+            int image_index;
+            int64_t start_ns;
+            int64_t duration_ns;
+            int64_t items;
+        };
+
+        struct ThreadEvents {
+            uint32_t thread_id;
+            std::vector<Event> events;
+        };
+
+        // Buffers are owned here so events survive the worker threads that recorded them.
+        struct Registry {
+            std::mutex mutex;
+            std::vector<std::shared_ptr<ThreadEvents>> threads;
+            std::set<std::string> names;
+        };
+
+        Registry& registry() {
+            static Registry instance;
+            return instance;
+        }
+
+        ThreadEvents& thread_events() {
+            thread_local std::shared_ptr<ThreadEvents> events = [] {
+                auto created = std::make_shared<ThreadEvents>();
+                Registry& reg = registry();
+                std::lock_guard<std::mutex> lock(reg.mutex);
+                created->thread_id = static_cast<uint32_t>(reg.threads.size());
+                created->events.reserve(4096);
+                reg.threads.push_back(created);
+                return created;
+            }();
+            return *events;
+        }
+
+        thread_local int current_image_index = -1;
+
+        int64_t now_ns() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        std::vector<std::pair<uint32_t, Event>> collect_events() {
+            Registry& reg = registry();
+            std::lock_guard<std::mutex> lock(reg.mutex);
+            std::vector<std::pair<uint32_t, Event>> events;
+            for (const auto& thread : reg.threads) {
+                for (const auto& event : thread->events) {
+                    events.emplace_back(thread->thread_id, event);
+                }
+            }
+            return events;
+        }
+
+        void write_json_string(std::ostream& out, const char* text) {
+            out << '"';
+            for (const char* c = text; *c; ++c) {
+                if (*c == '"' || *c == '\\') out << '\\';
+                out << *c;
+            }
+            out << '"';
+        }
+    }
+
+    bool enabled() {
+#ifdef IMAGEPROCESSING_PROFILING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    const char* intern(const std::string& name) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        return reg.names.insert(name).first->c_str();
+    }
+
+    ScopedTimer::ScopedTimer(const char* name, int image_index)
+        : name(name), image_index(image_index < 0 ? current_image_index : image_index),
+          previous_image_index(current_image_index), start_ns(now_ns()) {
+        current_image_index = this->image_index;
+    }
+
+    ScopedTimer::~ScopedTimer() {
+        int64_t end_ns = now_ns();
+        current_image_index = previous_image_index;
+        thread_events().events.push_back({name, image_index, start_ns, end_ns - start_ns, items});
+    }
+
+    bool write_chrome_trace(const std::string& path) {
+        std::ofstream out(path);
+        if (!out) return false;
+
+        std::vector<std::pair<uint32_t, Event>> events = collect_events();
+        int64_t origin_ns = events.empty() ? 0 : events.front().second.start_ns;
+        for (const auto& entry : events) {
+            origin_ns = std::min(origin_ns, entry.second.start_ns);
+        }
+
+        out << "{\"traceEvents\":[\n";
+        for (size_t i = 0; i < events.size(); ++i) {
+            const Event& event = events[i].second;
+            out << "{\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"cat\":\"pipeline\",\"ph\":\"X\""
+                << ",\"ts\":" << std::fixed << std::setprecision(3) << (event.start_ns - origin_ns) / 1000.0
+                << ",\"dur\":" << event.duration_ns / 1000.0
+                << ",\"pid\":1,\"tid\":" << events[i].first
+                << ",\"args\":{\"image_index\":" << event.image_index;
+            if (event.items >= 0) out << ",\"items\":" << event.items;
+            out << "}}" << (i + 1 < events.size() ? ",\n" : "\n");
+        }
+        out << "],\"displayTimeUnit\":\"ms\"}\n";
+        return static_cast<bool>(out);
+    }
+
+    void print_summary(std::ostream& out) {
+        struct Summary {
+            std::vector<int64_t> durations;
+            int64_t items = 0;
+            std::set<int> images;
+        };
+        std::map<std::string, Summary> stages;
+        for (const auto& entry : collect_events()) {
+            Summary& summary = stages[entry.second.name];
+            summary.durations.push_back(entry.second.duration_ns);
+            if (entry.second.items > 0) summary.items += entry.second.items;
+            if (entry.second.image_index >= 0) summary.images.insert(entry.second.image_index);
+        }
+
+        out << std::left << std::setw(28) << "stage" << std::right
+            << std::setw(8) << "calls" << std::setw(8) << "images"
+            << std::setw(12) << "total ms" << std::setw(10) << "mean ms"
+            << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms" << std::setw(10) << "max ms"
+            << std::setw(10) << "items" << '\n';
+        out << std::fixed << std::setprecision(3);
+        for (auto& stage : stages) {
+            std::vector<int64_t>& durations = stage.second.durations;
+            std::sort(durations.begin(), durations.end());
+            int64_t total = 0;
+            for (int64_t duration : durations) total += duration;
+            auto percentile = [&](double p) {
+                return durations[static_cast<size_t>(p * (durations.size() - 1))] / 1e6;
+            };
+            out << std::left << std::setw(28) << stage.first << std::right
+                << std::setw(8) << durations.size() << std::setw(8) << stage.second.images.size()
+                << std::setw(12) << total / 1e6 << std::setw(10) << total / 1e6 / durations.size()
+                << std::setw(10) << percentile(0.5) << std::setw(10) << percentile(0.95)
+                << std::setw(10) << durations.back() / 1e6
+                << std::setw(10) << stage.second.items << '\n';
+        }
+    }
+
+    void clear() {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        for (const auto& thread : reg.threads) {
+            thread->events.clear();
+        }
+    }
+}
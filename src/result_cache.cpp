@@ -0,0 +1,246 @@
+#include "header/result_cache.hpp"
+#include "header/result_stream.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace {
+    constexpr uint32_t cache_format_version = 1;
+    const char* const entry_extension = ".tsrc";
+
+    // File layout (host byte order): CacheFileHeader, then section_count sections of
+    // SectionHeader, name bytes, box_count result_stream::BoxRecords. The first section, with an empty
+    // name, holds the final boxes; the others hold the boxes of the named stages.
+    struct CacheFileHeader {
+        char magic[4];              // "TSRC"
+        uint32_t version;
+        uint32_t section_count;
+        uint32_t reserved;
+    };
+
+    struct SectionHeader {
+        uint32_t name_length;
+        uint32_t box_count;
+    };
+
+    void write_section(std::string& out, const std::string& name, const std::vector<BoundingBox>& bounding_boxes) {
+        SectionHeader section{static_cast<uint32_t>(name.size()), static_cast<uint32_t>(bounding_boxes.size())};
+        out.append(reinterpret_cast<const char*>(&section), sizeof(section));
+        out.append(name);
+        for (const auto& bounding_box : bounding_boxes) {
+            result_stream::BoxRecord record = result_stream::to_box_record(bounding_box, 0, bounding_box.image_index);
+            out.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+    }
+
+    bool read_section(std::istream& in, int image_index, std::string& name, std::vector<BoundingBox>& bounding_boxes) {
+        SectionHeader section{};
+        if (!in.read(reinterpret_cast<char*>(&section), sizeof(section)) || section.name_length > 4096) return false;
+        name.resize(section.name_length);
+        if (!in.read(&name[0], section.name_length)) return false;
+        bounding_boxes.clear();
+        for (uint32_t i = 0; i < section.box_count; i++) {
+            result_stream::BoxRecord record{};
+            if (!in.read(reinterpret_cast<char*>(&record), sizeof(record))) return false;
+            BoundingBox bounding_box = result_stream::from_box_record(record);
+            bounding_box.image_index = image_index;
+            bounding_boxes.push_back(std::move(bounding_box));
+        }
+        return true;
+    }
+
+    uint64_t hash_string(const std::string& value, uint64_t seed) {
+        // The length goes in first so that ("ab", "c") and ("a", "bc") hash differently.
+        uint64_t length = value.size();
+        return ResultCache::hash_bytes(value.data(), value.size(), ResultCache::hash_bytes(&length, sizeof(length), seed));
+    }
+}
+
+ResultCache::ResultCache(const std::string& directory, uint64_t max_bytes)
+    : directory(directory), max_bytes(max_bytes) {
+    fs::create_directories(directory);
+
+    struct ExistingFile {
+        fs::file_time_type modified;
+        std::string name;
+        uint64_t bytes;
+    };
+    std::vector<ExistingFile> existing;
+    for (const auto& dir_entry : fs::directory_iterator(directory)) {
+        if (!dir_entry.is_regular_file() || dir_entry.path().extension() != entry_extension) continue;
+        existing.push_back({dir_entry.last_write_time(), dir_entry.path().filename().string(), dir_entry.file_size()});
+    }
+    std::sort(existing.begin(), existing.end(),
+              [](const ExistingFile& a, const ExistingFile& b) { return a.modified < b.modified; });
+    for (const auto& file : existing) {
+        files[file.name] = {file.bytes, ++use_clock};
+        total_bytes += file.bytes;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    evict_locked();
+}
+
+std::string ResultCache::file_name(uint64_t image_hash, uint64_t config_hash) {
+    char name[48];
+    std::snprintf(name, sizeof(name), "%016llx-%016llx%s", static_cast<unsigned long long>(image_hash),
+                  static_cast<unsigned long long>(config_hash), entry_extension);
+    return name;
+}
+
+std::optional<ResultCache::Entry> ResultCache::lookup(uint64_t image_hash, uint64_t config_hash, int image_index) {
+    std::string name = file_name(image_hash, config_hash);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (files.find(name) == files.end()) {
+            counters.misses++;
+            return std::nullopt;
+        }
+    }
+
+    // Reading happens outside the lock. An entry evicted meanwhile either fails to open (a miss) or is
+    // still read completely, since the open file outlives its directory entry.
+    fs::path path = fs::path(directory) / name;
+    std::ifstream in(path, std::ios::binary);
+    CacheFileHeader header{};
+    Entry entry;
+    bool valid = in.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+                 std::memcmp(header.magic, "TSRC", 4) == 0 && header.version == cache_format_version &&
+                 header.section_count > 0;
+    std::string section_name;
+    std::vector<BoundingBox> section_boxes;
+    for (uint32_t s = 0; valid && s < header.section_count; s++) {
+        valid = read_section(in, image_index, section_name, section_boxes);
+        if (!valid) break;
+        if (s == 0) {
+            entry.bounding_boxes = std::move(section_boxes);
+        } else {
+            entry.stage_boxes[section_name] = std::move(section_boxes);
+        }
+        section_boxes.clear();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = files.find(name);
+    if (!valid) {
+        // Damaged or half-evicted entry: forget it, the caller recomputes and stores it again.
+        if (it != files.end()) {
+            total_bytes -= it->second.bytes;
+            files.erase(it);
+        }
+        std::error_code ignored;
+        fs::remove(path, ignored);
+        counters.misses++;
+        return std::nullopt;
+    }
+    if (it != files.end()) it->second.last_used = ++use_clock;
+    std::error_code ignored;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ignored);
+    counters.hits++;
+    return entry;
+}
+
+void ResultCache::store(uint64_t image_hash, uint64_t config_hash, const Entry& entry) {
+    std::string contents;
+    CacheFileHeader header{};
+    std::memcpy(header.magic, "TSRC", 4);
+    header.version = cache_format_version;
+    header.section_count = static_cast<uint32_t>(1 + entry.stage_boxes.size());
+    contents.append(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_section(contents, "", entry.bounding_boxes);
+    for (const auto& [stage_name, stage_boxes] : entry.stage_boxes) {
+        write_section(contents, stage_name, stage_boxes);
+    }
+
+    // Written to a temporary file and renamed, so readers never see a partial entry.
+    std::string name = file_name(image_hash, config_hash);
+    std::ostringstream temporary_name;
+    temporary_name << name << ".tmp" << std::this_thread::get_id();
+    fs::path temporary_path = fs::path(directory) / temporary_name.str();
+    {
+        std::ofstream out(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!out.write(contents.data(), static_cast<std::streamsize>(contents.size()))) {
+            std::cerr << "Error: Unable to write result cache entry " << temporary_path << std::endl;
+            return;
+        }
+    }
+    std::error_code error;
+    fs::rename(temporary_path, fs::path(directory) / name, error);
+    if (error) {
+        fs::remove(temporary_path, error);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = files.find(name);
+    if (it != files.end()) total_bytes -= it->second.bytes;
+    files[name] = {contents.size(), ++use_clock};
+    total_bytes += contents.size();
+    counters.stores++;
+    evict_locked();
+}
+
+void ResultCache::evict_locked() {
+    if (total_bytes <= max_bytes) return;
+    std::vector<std::pair<uint64_t, std::string>> by_use;
+    by_use.reserve(files.size());
+    for (const auto& [name, file] : files) {
+        by_use.emplace_back(file.last_used, name);
+    }
+    std::sort(by_use.begin(), by_use.end());
+    for (const auto& [last_used, name] : by_use) {
+        if (total_bytes <= max_bytes) break;
+        std::error_code ignored;
+        fs::remove(fs::path(directory) / name, ignored);
+        total_bytes -= files[name].bytes;
+        files.erase(name);
+        counters.evictions++;
+    }
+}
+
+void ResultCache::record_miss() {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.misses++;
+}
+
+ResultCache::Stats ResultCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats = counters;
+    stats.entries = files.size();
+    stats.bytes = total_bytes;
+    return stats;
+}
+
+uint64_t ResultCache::hash_bytes(const void* data, size_t size, uint64_t seed) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t ResultCache::hash_config(const pipeline_config::PipelineConfig& config) {
+    uint64_t hash = hash_bytes(&cache_format_version, sizeof(cache_format_version));
+    for (const auto& stage : config.stages) {
+        uint64_t counts[2] = {stage.inputs.size(), stage.params.size()};
+        hash = hash_bytes(counts, sizeof(counts), hash);
+        hash = hash_string(stage.name, hash);
+        hash = hash_string(stage.type, hash);
+        for (const auto& input : stage.inputs) hash = hash_string(input, hash);
+        // params is a std::map, so the order is stable.
+        for (const auto& [key, value] : stage.params) {
+            hash = hash_string(key, hash);
+            hash = hash_string(value, hash);
+        }
+    }
+    return hash_string(config.output_stage, hash);
+}
@@ -0,0 +1,192 @@
+#include "header/result_stream.hpp"
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace result_stream {
+    namespace {
+        void append_json_string(std::ostringstream& oss, const std::string& value) {
+            oss << '"';
+            for (char c : value) {
+                switch (c) {
+                    case '"': oss << "\\\""; break;
+                    case '\\': oss << "\\\\"; break;
+                    case '\n': oss << "\\n"; break;
+                    case '\t': oss << "\\t"; break;
+                    case '\r': oss << "\\r"; break;
+                    default:
+                        if (static_cast<unsigned char>(c) < 0x20) {
+                            char escaped[8];
+                            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+                            oss << escaped;
+                        } else {
+                            oss << c;
+                        }
+                }
+            }
+            oss << '"';
+        }
+    }
+
+    ShapeCode shape_code(const std::string& shape) {
+        if (shape == "Triangle") return TRIANGLE;
+        if (shape == "Rectangle") return RECTANGLE;
+        if (shape == "Circle") return CIRCLE;
+        return UNKNOWN_SHAPE;
+    }
+
+    std::string shape_name(uint8_t shape_code) {
+        switch (shape_code) {
+            case TRIANGLE: return "Triangle";
+            case RECTANGLE: return "Rectangle";
+            case CIRCLE: return "Circle";
+            default: return "Unknown";
+        }
+    }
+
+    BoxRecord to_box_record(const BoundingBox& bbox, uint32_t source_id, int image_index) {
+        BoxRecord record{};
+        record.type = BOX;
+        record.shape = shape_code(bbox.box_shape);
+        record.color[0] = bbox.box_color[0];
+        record.color[1] = bbox.box_color[1];
+        record.color[2] = bbox.box_color[2];
+        record.source_id = source_id;
+        record.image_index = image_index;
+        record.center_y = bbox.center_y;
+        record.center_x = bbox.center_x;
+        record.top = bbox.box_corners[0];
+        record.left = bbox.box_corners[1];
+        record.bottom = bbox.box_corners[2];
+        record.right = bbox.box_corners[3];
+        record.height = bbox.box_height;
+        record.width = bbox.box_width;
+        record.area = bbox.box_area;
+        return record;
+    }
+
+    BoundingBox from_box_record(const BoxRecord& record) {
+        return BoundingBox(record.center_y, record.center_x, {record.top, record.left, record.bottom, record.right},
+                           record.height, record.width, record.area,
+                           cv::Vec3b(record.color[0], record.color[1], record.color[2]),
+                           shape_name(record.shape), record.image_index);
+    }
+
+    Format parse_format(const std::string& name) {
+        if (name == "binary") return Format::Binary;
+        if (name == "jsonl") return Format::JsonLines;
+        throw std::invalid_argument("Unknown result format: " + name);
+    }
+
+    Writer::Writer(const std::string& path, Format format, size_t flush_bytes)
+        : format(format), flush_bytes(flush_bytes) {
+        file = std::fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            std::cerr << "Error: Unable to open result stream " << path << std::endl;
+            return;
+        }
+        buffer.reserve(flush_bytes + record_size * 16);
+
+        if (format == Format::Binary) {
+            StreamHeader header{};
+            std::memcpy(header.magic, "TSBX", 4);
+            header.version = format_version;
+            header.record_size = static_cast<uint16_t>(record_size);
+            append(&header, sizeof(header));
+        }
+    }
+
+    Writer::~Writer() {
+        if (file == nullptr) return;
+        flush();
+        std::fclose(file);
+    }
+
+    void Writer::append(const void* data, size_t size) {
+        const char* bytes = static_cast<const char*>(data);
+        buffer.insert(buffer.end(), bytes, bytes + size);
+    }
+
+    void Writer::flush() {
+        if (file == nullptr || buffer.empty()) return;
+        std::fwrite(buffer.data(), 1, buffer.size(), file);
+        std::fflush(file);
+        buffer.clear();
+    }
+
+    uint32_t Writer::get_source_id(const std::string& source_path) {
+        auto it = source_ids.find(source_path);
+        if (it != source_ids.end()) return it->second;
+
+        uint32_t source_id = static_cast<uint32_t>(source_ids.size());
+        source_ids.emplace(source_path, source_id);
+
+        if (format == Format::Binary) {
+            SourceRecord record{};
+            record.type = SOURCE;
+            record.source_id = source_id;
+            record.path_length = static_cast<uint32_t>(source_path.size());
+            append(&record, sizeof(record));
+
+            size_t padded_size = (source_path.size() + record_size - 1) / record_size * record_size;
+            append(source_path.data(), source_path.size());
+            buffer.insert(buffer.end(), padded_size - source_path.size(), 0);
+        }
+        return source_id;
+    }
+
+    void Writer::write(const std::string& source_path, int image_index, const std::vector<BoundingBox>& bounding_boxes) {
+        if (file == nullptr) return;
+
+        if (format == Format::Binary) {
+            write_binary(get_source_id(source_path), image_index, bounding_boxes);
+        } else {
+            write_json(source_path, image_index, bounding_boxes);
+        }
+        if (buffer.size() >= flush_bytes) flush();
+    }
+
+    void Writer::write_binary(uint32_t source_id, int image_index, const std::vector<BoundingBox>& bounding_boxes) {
+        ImageRecord image_record{};
+        image_record.type = IMAGE;
+        image_record.source_id = source_id;
+        image_record.image_index = image_index;
+        image_record.box_count = static_cast<uint32_t>(bounding_boxes.size());
+        append(&image_record, sizeof(image_record));
+
+        for (const auto& bbox : bounding_boxes) {
+            BoxRecord record = to_box_record(bbox, source_id, image_index);
+            append(&record, sizeof(record));
+        }
+    }
+
+    void Writer::write_json(const std::string& source_path, int image_index, const std::vector<BoundingBox>& bounding_boxes) {
+        std::ostringstream oss;
+        oss << "{\"source\":";
+        append_json_string(oss, source_path);
+        oss << ",\"image_index\":" << image_index << ",\"boxes\":[";
+        for (size_t i = 0; i < bounding_boxes.size(); ++i) {
+            const BoundingBox& bbox = bounding_boxes[i];
+            if (i > 0) oss << ',';
+            oss << "{\"center_y\":" << bbox.center_y
+                << ",\"center_x\":" << bbox.center_x
+                << ",\"top\":" << bbox.box_corners[0]
+                << ",\"left\":" << bbox.box_corners[1]
+                << ",\"bottom\":" << bbox.box_corners[2]
+                << ",\"right\":" << bbox.box_corners[3]
+                << ",\"height\":" << bbox.box_height
+                << ",\"width\":" << bbox.box_width
+                << ",\"area\":" << bbox.box_area
+                << ",\"color\":[" << static_cast<int>(bbox.box_color[0])
+                << ',' << static_cast<int>(bbox.box_color[1])
+                << ',' << static_cast<int>(bbox.box_color[2]) << "]"
+                << ",\"shape\":";
+            append_json_string(oss, bbox.box_shape);
+            oss << '}';
+        }
+        oss << "]}\n";
+        const std::string line = oss.str();
+        append(line.data(), line.size());
+    }
+}
@@ -0,0 +1,26 @@
+#include "header/scratch_buffers.hpp"
+
+namespace scratch {
+    namespace {
+        thread_local std::array<std::vector<uchar>, SLOT_COUNT> buffers;
+    }
+
+    cv::Mat mat(Slot slot, int rows, int cols, int type) {
+        size_t bytes = static_cast<size_t>(rows) * cols * CV_ELEM_SIZE(type);
+        std::vector<uchar>& buffer = buffers[slot];
+        if (buffer.size() < bytes) {
+            // The old contents are dead, so drop them instead of copying them over.
+            buffer.clear();
+            buffer.resize(bytes);
+        }
+        return cv::Mat(rows, cols, type, buffer.data());
+    }
+
+    size_t reserved_bytes() {
+        size_t bytes = 0;
+        for (const auto& buffer : buffers) {
+            bytes += buffer.size();
+        }
+        return bytes;
+    }
+}
@@ -1,33 +1,48 @@
 #include "header/statistical_operations.hpp"
 #include <cmath>
-#include <numeric>
 #include <algorithm>
 
-cv::Mat gauss_filter(const cv::Mat& image, int dim) {
-    if (image.channels() != 1 || dim % 2 == 0) return cv::Mat();
+namespace stat_ops {
+    // Box average over the part of the dim x dim window that lies inside the image, computed with running
+    // column and row sums so the cost per pixel does not depend on dim.
+    cv::Mat gauss_filter(const cv::Mat& image, int dim) {
+        if (image.channels() != 1 || dim % 2 == 0) return cv::Mat();
+
+        int half_dim = dim / 2;
+        cv::Mat result(image.size(), image.type());
+        int height = image.rows;
+        int width = image.cols;
+
+        std::vector<uint32_t> column_sums(width, 0);
+        for (int y = 0; y < std::min(height, half_dim + 1); ++y) {
+            const uint8_t* row = image.ptr<uint8_t>(y);
+            for (int x = 0; x < width; ++x) column_sums[x] += row[x];
+        }
 
-    int half_dim = dim / 2;
-    cv::Mat result = image.clone();
-    int height = image.rows;
-    int width = image.cols;
+        for (int y = 0; y < height; ++y) {
+            uint32_t window_rows = std::min(height - 1, y + half_dim) - std::max(0, y - half_dim) + 1;
+            uint32_t sum = 0;
+            for (int x = 0; x < std::min(width, half_dim + 1); ++x) sum += column_sums[x];
+
+            uint8_t* out = result.ptr<uint8_t>(y);
+            for (int x = 0; x < width; ++x) {
+                uint32_t window_cols = std::min(width - 1, x + half_dim) - std::max(0, x - half_dim) + 1;
+                out[x] = static_cast<uint8_t>(sum / (window_rows * window_cols));
+                if (x + half_dim + 1 < width) sum += column_sums[x + half_dim + 1];
+                if (x - half_dim >= 0) sum -= column_sums[x - half_dim];
+            }
 
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            std::vector<uint16_t> pixels;
-            for (int a = -half_dim; a <= half_dim; ++a) {
-                for (int b = -half_dim; b <= half_dim; ++b) {
-                    int ny = y + a;
-                    int nx = x + b;
-                    if (ny >= 0 && ny < height && nx >= 0 && nx < width) {
-                        pixels.push_back(image.at<uint8_t>(ny, nx));
-                    }
-                }
+            if (y + half_dim + 1 < height) {
+                const uint8_t* row = image.ptr<uint8_t>(y + half_dim + 1);
+                for (int x = 0; x < width; ++x) column_sums[x] += row[x];
+            }
+            if (y - half_dim >= 0) {
+                const uint8_t* row = image.ptr<uint8_t>(y - half_dim);
+                for (int x = 0; x < width; ++x) column_sums[x] -= row[x];
             }
-            uint32_t sum = std::accumulate(pixels.begin(), pixels.end(), 0u);
-            result.at<uint8_t>(y, x) = static_cast<uint8_t>(sum / pixels.size());
         }
+        return result;
     }
-    return result;
 }
 
 int co_occurrence(const cv::Mat& image, std::function<bool(const cv::Mat&, int, int)> relation_function) {
@@ -0,0 +1,122 @@
+#include "header/thread_pool.hpp"
+#include <algorithm>
+#include <exception>
+
+namespace {
+    // The pool and deque index of the worker running on this thread, if any.
+    thread_local const ThreadPool* current_pool = nullptr;
+    thread_local size_t current_worker = 0;
+}
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < num_threads; ++i) {
+        threads.emplace_back([this, i] { worker_loop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t worker_index = next_worker.fetch_add(1) % workers.size();
+    {
+        std::lock_guard<std::mutex> lock(workers[worker_index]->mutex);
+        // Count the task before it becomes visible, or a thief could decrement first and wrap the counter.
+        queued_tasks.fetch_add(1);
+        workers[worker_index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::take_task(size_t worker_index, std::function<void()>& task) {
+    {
+        Worker& own = *workers[worker_index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued_tasks.fetch_sub(1);
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < workers.size(); ++offset) {
+        Worker& victim = *workers[(worker_index + offset) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued_tasks.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t worker_index) {
+    current_pool = this;
+    current_worker = worker_index;
+    while (true) {
+        std::function<void()> task;
+        if (take_task(worker_index, task)) {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake.wait(lock, [this] { return stopping || queued_tasks.load() > 0; });
+        if (stopping && queued_tasks.load() == 0) return;
+    }
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) return;
+
+    size_t remaining = count;
+    std::mutex done_mutex;
+    std::condition_variable done;
+    std::exception_ptr first_error;
+
+    for (size_t i = 0; i < count; ++i) {
+        submit([&, i] {
+            std::exception_ptr error;
+            try {
+                body(i);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if (error && !first_error) first_error = error;
+            if (--remaining == 0) done.notify_all();
+        });
+    }
+
+    if (current_pool == this) {
+        // Once no task is left in any deque, all of ours are running on other workers and waiting is safe.
+        std::function<void()> task;
+        while (take_task(current_worker, task)) {
+            task();
+            std::lock_guard<std::mutex> lock(done_mutex);
+            if (remaining == 0) break;
+        }
+    }
+
+    std::unique_lock<std::mutex> lock(done_mutex);
+    done.wait(lock, [&] { return remaining == 0; });
+    if (first_error) std::rethrow_exception(first_error);
+}
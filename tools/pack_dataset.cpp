@@ -0,0 +1,76 @@
+#include "../src/header/packed_dataset.hpp"
+#include "../src/header/preprocessing_pipeline.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Decodes and preprocesses image folders once and stores the frames in a packed dataset, which
+// ImageProcessingCpp --packed PATH then maps instead of decoding the JPEGs again.
+//
+// Usage: pack_dataset OUTPUT [--frames resized,color,shape] [--resize N] [--threads N] [--max-images N] [FOLDER...]
+// Without folders the default image folders of the pipeline are packed. ImageProcessingCpp only accepts packs
+// built with the default --resize of 8 (pipeline_preprocessing::RESIZE_FACTOR).
+
+int main(int argc, char** argv) {
+    std::string output_path;
+    std::vector<std::string> folders;
+    packed_dataset::PackOptions options;
+    int max_images = 100;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            options.frame_kinds = 0;
+            std::stringstream kinds(argv[++i]);
+            std::string kind;
+            while (std::getline(kinds, kind, ',')) {
+                if (kind == "resized") {
+                    options.frame_kinds |= packed_dataset::frame_bit(packed_dataset::RESIZED);
+                } else if (kind == "color") {
+                    options.frame_kinds |= packed_dataset::frame_bit(packed_dataset::COLOR);
+                } else if (kind == "shape") {
+                    options.frame_kinds |= packed_dataset::frame_bit(packed_dataset::SHAPE);
+                } else {
+                    std::cerr << "Unknown frame kind: " << kind << std::endl;
+                    return 2;
+                }
+            }
+        } else if (arg == "--resize" && i + 1 < argc) {
+            options.resize_factor = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.num_threads = static_cast<size_t>(std::stoul(argv[++i]));
+        } else if (arg == "--max-images" && i + 1 < argc) {
+            max_images = std::stoi(argv[++i]);
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 2;
+        } else if (output_path.empty()) {
+            output_path = arg;
+        } else {
+            folders.push_back(arg);
+        }
+    }
+    if (output_path.empty()) {
+        std::cerr << "Usage: pack_dataset OUTPUT [--frames resized,color,shape] [--resize N] [--threads N] "
+                     "[--max-images N] [FOLDER...]" << std::endl;
+        return 2;
+    }
+    if (folders.empty()) folders = pipeline_preprocessing::get_image_folders();
+
+    std::vector<std::string> image_paths = pipeline_preprocessing::get_image_paths(folders, max_images);
+    auto start = std::chrono::steady_clock::now();
+    size_t packed;
+    try {
+        packed = packed_dataset::pack_images(image_paths, output_path, options);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Packed " << packed << " of " << image_paths.size() << " images into " << output_path
+              << " in " << seconds << " s" << std::endl;
+    return packed == image_paths.size() ? 0 : 1;
+}